@@ -0,0 +1,154 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Throughput benchmark of the entropy kernel in 'src/entropy.c'. See the
+ * 'bench' target of the Makefile.
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime() */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/include/entropy.h"
+
+/*
+ * Default size of the benchmarked buffer, in MiB, and size of each block.
+ */
+#define DEFAULT_BUFFER_MIB 512
+#define BLOCK_SIZE         256
+
+/*
+ * Number of times each function is timed. The fastest run is reported.
+ */
+#define RUNS 5
+
+/*
+ * Total of the results of all the calls, printed so the calls can't be
+ * optimized away.
+ */
+static double g_checksum = 0.0;
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Get the current time of a monotonic clock, in seconds.
+ */
+static double get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/*
+ * Fill a buffer with pseudo-random bytes from a 'xorshift64' generator, so the
+ * blocks are never empty or uniform.
+ */
+static void fill_random(uint8_t* buf, size_t buf_sz) {
+    uint64_t state = 0x9E3779B97F4A7C15;
+    for (size_t i = 0; i < buf_sz; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        buf[i] = (uint8_t)(state >> 56);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+static void bench_count_bytes(const EntropyTable* table,
+                              const uint8_t* buf,
+                              size_t buf_sz) {
+    (void)table;
+
+    size_t occurrences[ENTROPY_BINS] = { 0 };
+    for (size_t i = 0; i + BLOCK_SIZE <= buf_sz; i += BLOCK_SIZE)
+        entropy_count_bytes(&buf[i], BLOCK_SIZE, occurrences);
+
+    for (int byte = 0; byte < ENTROPY_BINS; byte++)
+        g_checksum += occurrences[byte];
+}
+
+static void bench_entropy_of_block(const EntropyTable* table,
+                                   const uint8_t* buf,
+                                   size_t buf_sz) {
+    double sum = 0.0;
+    for (size_t i = 0; i + BLOCK_SIZE <= buf_sz; i += BLOCK_SIZE)
+        sum += entropy_of_block(table, &buf[i], BLOCK_SIZE);
+
+    g_checksum += sum;
+}
+
+/*
+ * Time the specified function over the whole buffer, and print its throughput
+ * in GB/s.
+ */
+static void bench(const char* name,
+                  void (*func)(const EntropyTable*, const uint8_t*, size_t),
+                  const EntropyTable* table,
+                  const uint8_t* buf,
+                  size_t buf_sz) {
+    double best = 0.0;
+    for (int run = 0; run < RUNS; run++) {
+        const double start = get_time();
+        func(table, buf, buf_sz);
+        const double elapsed = get_time() - start;
+        if (run == 0 || elapsed < best)
+            best = elapsed;
+    }
+
+    printf("%-20s %6.2f GB/s\n", name, (double)buf_sz / best / 1e9);
+}
+
+/*----------------------------------------------------------------------------*/
+
+int main(int argc, char** argv) {
+    size_t buffer_mib = DEFAULT_BUFFER_MIB;
+    if (argc > 2 || (argc == 2 && sscanf(argv[1], "%zu", &buffer_mib) != 1) ||
+        buffer_mib == 0) {
+        fprintf(stderr, "Usage: %s [BUFFER-MIB]\n", argv[0]);
+        return 1;
+    }
+
+    const size_t buf_sz = buffer_mib * 1024 * 1024;
+    uint8_t* buf        = malloc(buf_sz);
+    if (buf == NULL) {
+        fprintf(stderr, "Failed to allocate %zu MiB.\n", buffer_mib);
+        return 1;
+    }
+    fill_random(buf, buf_sz);
+
+    EntropyTable table;
+    if (!entropy_table_init(&table, BLOCK_SIZE)) {
+        fprintf(stderr, "Failed to initialize the entropy table.\n");
+        free(buf);
+        return 1;
+    }
+
+    bench("entropy_count_bytes", bench_count_bytes, &table, buf, buf_sz);
+    bench("entropy_of_block", bench_entropy_of_block, &table, buf, buf_sz);
+    printf("Checksum: %f\n", g_checksum);
+
+    entropy_table_deinit(&table);
+    free(buf);
+    return 0;
+}
@@ -5,11 +5,21 @@ _bin_graph_completion() {
     arg_opts=(
         -m --mode
         -w --width
+        --max-height --max-pixels
         -z --zoom
+        -j --jobs
         --block-size
+        --kgram-size
+        --scale
         --offset-start --offset-end
+        --region
         --output-format
+        --png-compression
+        --transform
         --transform-squares
+        --transform-morton
+        --transform-hilbert
+        --layout-cache
     )
     nonarg_opts=(
         -h --help
@@ -44,9 +44,9 @@ input_file="${*: -1}"
 "$BIN_GRAPH" --mode 'grayscale' "$input_file" "${input_file}.grayscale.png"
 "$BIN_GRAPH" --mode 'ascii' "$input_file" "${input_file}.ascii.png"
 "$BIN_GRAPH" --mode 'entropy' --transform-squares 16 "$input_file" "${input_file}.entropy.png"
+"$BIN_GRAPH" --mode 'sliding-entropy' "$input_file" "${input_file}.sliding-entropy.png"
 "$BIN_GRAPH" --mode 'histogram' "$input_file" "${input_file}.histogram.png"
 "$BIN_GRAPH" --mode 'bigrams' "$input_file" "${input_file}.bigrams.png"
-"$BIN_GRAPH" --mode 'dotplot' --offset-start 0 --offset-end 1000 "$input_file" "${input_file}.dotplot1.png"
-"$BIN_GRAPH" --mode 'dotplot' --offset-start 4000 --offset-end 5000 "$input_file" "${input_file}.dotplot2.png"
-"$BIN_GRAPH" --mode 'dotplot' --offset-start 10000 --offset-end 11000 "$input_file" "${input_file}.dotplot3.png"
-"$BIN_GRAPH" --mode 'dotplot' --offset-start 30000 --offset-end 31000 "$input_file" "${input_file}.dotplot4.png"
+"$BIN_GRAPH" --mode 'dotplot' --region 0:1000 --region 4000:5000 --region 10000:11000 --region 30000:31000 "$input_file" "${input_file}.dotplot.png"
+"$BIN_GRAPH" --mode 'dotplot-density' "$input_file" "${input_file}.dotplot-density.png"
+"$BIN_GRAPH" --mode 'dotplot-kgram' "$input_file" "${input_file}.dotplot-kgram.png"
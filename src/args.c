@@ -46,11 +46,20 @@
 enum ELongOptionIds {
     LONGOPT_OFFSET_START = 256,
     LONGOPT_OFFSET_END,
+    LONGOPT_REGION,
     LONGOPT_BLOCK_SIZE,
+    LONGOPT_KGRAM_SIZE,
+    LONGOPT_SCALE,
     LONGOPT_OUTPUT_FORMAT,
+    LONGOPT_PNG_COMPRESSION,
+    LONGOPT_MAX_HEIGHT,
+    LONGOPT_MAX_PIXELS,
+    LONGOPT_TRANSFORM,
     LONGOPT_TRANSFORM_SQUARES,
     LONGOPT_TRANSFORM_ZIGZAG,
     LONGOPT_TRANSFORM_HILBERT,
+    LONGOPT_TRANSFORM_MORTON,
+    LONGOPT_LAYOUT_CACHE,
     LONGOPT_LIST_MODES,
     LONGOPT_LIST_OUTPUT_FORMATS,
 };
@@ -99,6 +108,14 @@ static struct {
               "each line indicates the entropy of that block relative to the "
               "maximum possible entropy.",
     },
+    {
+      .mode = ARGS_MODE_SLIDING_ENTROPY,
+      .name = "sliding-entropy",
+      .desc = "Similar to the entropy mode, but the entropy of each sample is "
+              "calculated from a window of the block size, centered on that "
+              "sample. The boundaries between regions are therefore not "
+              "aligned to blocks.",
+    },
     {
       .mode = ARGS_MODE_HISTOGRAM,
       .name = "histogram",
@@ -110,8 +127,9 @@ static struct {
       .mode = ARGS_MODE_BIGRAMS,
       .name = "bigrams",
       .desc = "The coordinates of each point are determined by a pair of "
-              "samples in the input. This can be used to identify patterns of "
-              "different file formats.",
+              "samples in the input, and its intensity by the occurrences of "
+              "that pair, using the selected scale. This can be used to "
+              "identify patterns of different file formats.",
     },
     {
       .mode = ARGS_MODE_DOTPLOT,
@@ -119,6 +137,21 @@ static struct {
       .desc = "Measure self-similarity. A point (X,Y) in the graph shows if "
               "the X-th sample matches the Y-th sample.",
     },
+    {
+      .mode = ARGS_MODE_DOTPLOT_DENSITY,
+      .name = "dotplot-density",
+      .desc = "Similar to the dotplot mode, but the input is split into as "
+              "many tiles as the output width. A point (X,Y) shows the ratio "
+              "of matching samples between the X-th and Y-th tiles, relative "
+              "to the highest ratio, using the selected scale.",
+    },
+    {
+      .mode = ARGS_MODE_DOTPLOT_KGRAM,
+      .name = "dotplot-kgram",
+      .desc = "Similar to the dotplot mode, but a point (X,Y) is set if the "
+              "sequences of k-gram size starting at the X-th and Y-th samples "
+              "match. The input is scaled down to the output width if needed.",
+    },
 };
 
 /*
@@ -139,6 +172,83 @@ static struct {
       .name   = "escaped-text",
       .desc   = "Export as ANSI-escaped colored text.",
     },
+    {
+      .format = ARGS_OUTPUT_FORMAT_ESC_TEXT_HALF,
+      .name   = "escaped-text-half",
+      .desc   = "Export as ANSI-escaped colored text, drawing two rows of "
+                "pixels in each line with half block characters. Like in "
+                "escaped-text, the zoom is only applied horizontally.",
+    },
+    {
+      .format = ARGS_OUTPUT_FORMAT_SIXEL,
+      .name   = "sixel",
+      .desc   = "Export as sixel graphics, for terminals that support them. "
+                "Images with more than 256 colors are approximated.",
+    },
+    {
+      .format = ARGS_OUTPUT_FORMAT_KITTY,
+      .name   = "kitty",
+      .desc   = "Export as compressed RGB pixels for terminals that support "
+                "the kitty graphics protocol.",
+    },
+    {
+      .format = ARGS_OUTPUT_FORMAT_PPM,
+      .name   = "ppm",
+      .desc   = "Export as an uncompressed binary PPM file with RGB pixels, "
+                "useful for piping the image into other programs.",
+    },
+    {
+      .format = ARGS_OUTPUT_FORMAT_PAM,
+      .name   = "pam",
+      .desc   = "Export as an uncompressed PAM file, with a single channel if "
+                "all the colors are gray, or RGB pixels otherwise.",
+    },
+    {
+      .format = ARGS_OUTPUT_FORMAT_DZI,
+      .name   = "dzi",
+      .desc   = "Export as a Deep Zoom pyramid of 256x256 PNG tiles, for "
+                "browsing huge images. The output file is the XML manifest, "
+                "and the tiles are written to a directory named after it, "
+                "ending in \"_files\". The zoom is ignored.",
+    },
+};
+
+/*
+ * Intensity scale names used when parsing the program arguments.
+ */
+static struct {
+    enum EArgsScale scale;
+    const char* name;
+} g_scale_names[] = {
+    { ARGS_SCALE_LINEAR, "linear" },
+    { ARGS_SCALE_LOG, "log" },
+};
+
+/*
+ * Transformation names used when parsing the program arguments, and whether
+ * they need a parameter.
+ */
+static struct {
+    enum EArgsTransform type;
+    const char* name;
+    bool has_param;
+} g_transform_names[] = {
+    { ARGS_TRANSFORM_SQUARES, "squares", true },
+    { ARGS_TRANSFORM_ZIGZAG, "zigzag", false },
+    { ARGS_TRANSFORM_HILBERT, "hilbert", true },
+    { ARGS_TRANSFORM_MORTON, "morton", true },
+};
+
+/*
+ * PNG compression preset names used when parsing the program arguments.
+ */
+static struct {
+    enum EArgsPngCompression preset;
+    const char* name;
+} g_png_compression_names[] = {
+    { ARGS_PNG_COMPRESSION_FAST, "fast" },
+    { ARGS_PNG_COMPRESSION_DEFAULT, "default" },
+    { ARGS_PNG_COMPRESSION_BEST, "best" },
 };
 
 /*
@@ -154,6 +264,15 @@ static struct argp_option options[] = {
       "Set the current mode to MODE. Use `--list-modes' for a list of modes.",
       1,
     },
+    {
+      "jobs",
+      'j',
+      "N",
+      0,
+      "Use up to N threads in the modes that support it (e.g. entropy). By "
+      "default, the number of online processors is used.",
+      1,
+    },
     { NULL, 0, NULL, 0, "Input options", 2 },
     {
       "offset-start",
@@ -173,6 +292,17 @@ static struct argp_option options[] = {
       "without any prefix. Zero means the end of the file.",
       2,
     },
+    {
+      "region",
+      LONGOPT_REGION,
+      "START:END",
+      0,
+      "Process the file from START to END, which are specified in hexadecimal "
+      "format, without any prefix. An empty END means the end of the file. "
+      "Can be specified multiple times, and the image of each region will be "
+      "stacked vertically in the output. Can't be combined with `--offset-*'.",
+      2,
+    },
     {
       "block-size",
       LONGOPT_BLOCK_SIZE,
@@ -181,6 +311,23 @@ static struct argp_option options[] = {
       "Set the size for some block-specific modes like entropy.",
       2,
     },
+    {
+      "kgram-size",
+      LONGOPT_KGRAM_SIZE,
+      "BYTES",
+      0,
+      "Set the length of the sequences compared by the dotplot-kgram mode.",
+      2,
+    },
+    {
+      "scale",
+      LONGOPT_SCALE,
+      "SCALE",
+      0,
+      "Set the intensity scale of the modes that count occurrences, like "
+      "bigrams. Can be `linear' or `log' (default).",
+      2,
+    },
     { NULL, 0, NULL, 0, "Output options", 3 },
     {
       "output-format",
@@ -199,6 +346,15 @@ static struct argp_option options[] = {
       "Scale each pixel by FACTOR.",
       3,
     },
+    {
+      "png-compression",
+      LONGOPT_PNG_COMPRESSION,
+      "PRESET",
+      0,
+      "Set the filtering and compression used for PNG images. Can be `fast', "
+      "`default' or `best'.",
+      3,
+    },
     {
       "width",
       'w',
@@ -209,14 +365,46 @@ static struct argp_option options[] = {
       "each row before applying the zoom.",
       3,
     },
+    {
+      "max-height",
+      LONGOPT_MAX_HEIGHT,
+      "ROWS",
+      0,
+      "Limit the height of the image to ROWS before applying the zoom, "
+      "aggregating multiple samples into each pixel if needed. Only supported "
+      "by the grayscale (mean), ascii (most common) and entropy (maximum) "
+      "modes.",
+      3,
+    },
+    {
+      "max-pixels",
+      LONGOPT_MAX_PIXELS,
+      "NUM",
+      0,
+      "Similar to `--max-height', but limit the number of pixels of the image "
+      "to NUM, or to a single row if NUM is smaller than the width.",
+      3,
+    },
+    {
+      "transform",
+      LONGOPT_TRANSFORM,
+      "NAME[:ARG]",
+      0,
+      "After generating the image, transform it with NAME. Can be specified "
+      "multiple times, and each transformation is applied to the output of the "
+      "previous one, moving each pixel only once. Can be `squares:SIDE', "
+      "`zigzag', `hilbert:LEVEL' or `morton:LEVEL'. The `--transform-NAME' "
+      "options are shorthands for each of them.",
+      3,
+    },
     {
       "transform-squares",
       LONGOPT_TRANSFORM_SQUARES,
       "SIDE",
       0,
-      "After generating the image, group its pixels into squares of side SIDE. "
-      "If the image dimensions are not divisible by SIDE, they will be "
-      "increased. This option is useful with the entropy mode.",
+      "Group the pixels of the image into squares of side SIDE. If the image "
+      "dimensions are not divisible by SIDE, they will be increased. This "
+      "option is useful with the entropy mode.",
       3,
     },
     {
@@ -237,6 +425,26 @@ static struct argp_option options[] = {
       "specified recursion LEVEL.",
       3,
     },
+    {
+      "transform-morton",
+      LONGOPT_TRANSFORM_MORTON,
+      "LEVEL",
+      0,
+      "Transform the image using the Z-order (Morton) curve, with the specified "
+      "recursion LEVEL. Similar to `--transform-hilbert', but faster and with "
+      "worse locality.",
+      3,
+    },
+    {
+      "layout-cache",
+      LONGOPT_LAYOUT_CACHE,
+      "DIR",
+      0,
+      "Store the pixel positions of the transformations in DIR, and reuse them "
+      "in later runs with the same transformation and width. The directory is "
+      "created if it doesn't exist.",
+      3,
+    },
     { NULL, 0, NULL, 0, "Help options", 4 },
     {
       "list-modes",
@@ -291,6 +499,62 @@ static bool output_format_name_to_enumerator(const char* name,
     return false;
 }
 
+/*
+ * Write the corresponding scale enumerator from its name. The function returns
+ * true on success, or false if the provided name does not match any scale.
+ */
+static bool scale_name_to_enumerator(const char* name, enum EArgsScale* out) {
+    for (size_t i = 0; i < LENGTH(g_scale_names); i++) {
+        if (strcmp(name, g_scale_names[i].name) == 0) {
+            *out = g_scale_names[i].scale;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Write the corresponding PNG compression preset enumerator from its name. The
+ * function returns true on success, or false if the provided name does not
+ * match any preset.
+ */
+static bool png_compression_name_to_enumerator(const char* name,
+                                               enum EArgsPngCompression* out) {
+    for (size_t i = 0; i < LENGTH(g_png_compression_names); i++) {
+        if (strcmp(name, g_png_compression_names[i].name) == 0) {
+            *out = g_png_compression_names[i].preset;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Append a transformation to the chain in the 'Args' structure, exiting if the
+ * chain is full. Squares of a single pixel are ignored, since they don't move
+ * any pixel.
+ */
+static void append_transform(struct argp_state* state,
+                             Args* parsed_args,
+                             enum EArgsTransform type,
+                             size_t param) {
+    if (type == ARGS_TRANSFORM_SQUARES && param <= 1)
+        return;
+
+    if (parsed_args->transforms_num >= ARGS_MAX_TRANSFORMS) {
+        fprintf(state->err_stream,
+                "%s: Too many transformations (maximum is %d).\n",
+                state->name,
+                ARGS_MAX_TRANSFORMS);
+        argp_usage(state);
+    }
+
+    ArgsTransform* transform =
+      &parsed_args->transforms[parsed_args->transforms_num++];
+    transform->type  = type;
+    transform->param = param;
+}
+
 /*
  * Callback function used by the Argp library (specifically, by 'argp_parse'
  * through the 'argp' structure) for parsing each option in the command-line
@@ -314,6 +578,18 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
             }
         } break;
 
+        case 'j': {
+            int signed_jobs;
+            if (sscanf(arg, "%d", &signed_jobs) != 1 || signed_jobs <= 0) {
+                fprintf(state->err_stream,
+                        "%s: The number of jobs must be an integer greater "
+                        "than zero.\n",
+                        state->name);
+                argp_usage(state);
+            }
+            parsed_args->jobs = signed_jobs;
+        } break;
+
         case 'z': {
             int signed_zoom;
             if (sscanf(arg, "%d", &signed_zoom) != 1 || signed_zoom <= 0) {
@@ -337,6 +613,28 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
             parsed_args->output_width = signed_width;
         } break;
 
+        case LONGOPT_MAX_HEIGHT: {
+            if (sscanf(arg, "%zu", &parsed_args->max_height) != 1 ||
+                parsed_args->max_height == 0) {
+                fprintf(state->err_stream,
+                        "%s: The maximum height must be an integer greater "
+                        "than zero.\n",
+                        state->name);
+                argp_usage(state);
+            }
+        } break;
+
+        case LONGOPT_MAX_PIXELS: {
+            if (sscanf(arg, "%zu", &parsed_args->max_pixels) != 1 ||
+                parsed_args->max_pixels == 0) {
+                fprintf(state->err_stream,
+                        "%s: The maximum number of pixels must be an integer "
+                        "greater than zero.\n",
+                        state->name);
+                argp_usage(state);
+            }
+        } break;
+
         case LONGOPT_OUTPUT_FORMAT: {
             if (!output_format_name_to_enumerator(arg,
                                                   &parsed_args
@@ -349,6 +647,18 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
             }
         } break;
 
+        case LONGOPT_PNG_COMPRESSION: {
+            if (!png_compression_name_to_enumerator(
+                  arg,
+                  &parsed_args->png_compression)) {
+                fprintf(state->err_stream,
+                        "%s: Unknown PNG compression preset '%s'\n",
+                        state->name,
+                        arg);
+                argp_usage(state);
+            }
+        } break;
+
         case LONGOPT_OFFSET_START: {
             if (sscanf(arg, "%zx", &parsed_args->offset_start) != 1) {
                 fprintf(state->err_stream,
@@ -369,6 +679,43 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
             }
         } break;
 
+        case LONGOPT_REGION: {
+            if (parsed_args->regions_num >= ARGS_MAX_REGIONS) {
+                fprintf(state->err_stream,
+                        "%s: Too many regions (maximum is %d).\n",
+                        state->name,
+                        ARGS_MAX_REGIONS);
+                argp_usage(state);
+            }
+
+            ArgsRegion* region =
+              &parsed_args->regions[parsed_args->regions_num];
+            region->end = 0;
+
+            int chars_read = 0;
+            if (sscanf(arg, "%zx:%n", &region->start, &chars_read) != 1 ||
+                chars_read == 0 ||
+                (arg[chars_read] != '\0' &&
+                 sscanf(&arg[chars_read], "%zx", &region->end) != 1)) {
+                fprintf(state->err_stream,
+                        "%s: Invalid format for region. Example: "
+                        "\"e1c5:f000\".\n",
+                        state->name);
+                argp_usage(state);
+            }
+            if (region->end != 0 && region->end <= region->start) {
+                fprintf(state->err_stream,
+                        "%s: The end of the region (%zx) must be bigger than "
+                        "the start (%zx).\n",
+                        state->name,
+                        region->end,
+                        region->start);
+                argp_usage(state);
+            }
+
+            parsed_args->regions_num++;
+        } break;
+
         case LONGOPT_BLOCK_SIZE: {
             int signed_size;
             if (sscanf(arg, "%d", &signed_size) != 1 || signed_size <= 0) {
@@ -381,6 +728,67 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
             parsed_args->block_size = signed_size;
         } break;
 
+        case LONGOPT_KGRAM_SIZE: {
+            int signed_size;
+            if (sscanf(arg, "%d", &signed_size) != 1 || signed_size <= 0) {
+                fprintf(state->err_stream,
+                        "%s: The k-gram size must be an integer greater than "
+                        "zero.\n",
+                        state->name);
+                argp_usage(state);
+            }
+            parsed_args->kgram_size = signed_size;
+        } break;
+
+        case LONGOPT_SCALE: {
+            if (!scale_name_to_enumerator(arg, &parsed_args->scale)) {
+                fprintf(state->err_stream,
+                        "%s: Unknown scale '%s'\n",
+                        state->name,
+                        arg);
+                argp_usage(state);
+            }
+        } break;
+
+        case LONGOPT_TRANSFORM: {
+            const char* separator = strchr(arg, ':');
+            const size_t name_len =
+              (separator == NULL) ? strlen(arg) : (size_t)(separator - arg);
+
+            size_t i = 0;
+            for (; i < LENGTH(g_transform_names); i++)
+                if (strlen(g_transform_names[i].name) == name_len &&
+                    strncmp(arg, g_transform_names[i].name, name_len) == 0)
+                    break;
+            if (i >= LENGTH(g_transform_names)) {
+                fprintf(state->err_stream,
+                        "%s: Unknown transformation '%s'\n",
+                        state->name,
+                        arg);
+                argp_usage(state);
+            }
+
+            int signed_param = 0;
+            if (g_transform_names[i].has_param != (separator != NULL) ||
+                (separator != NULL &&
+                 (sscanf(separator + 1, "%d", &signed_param) != 1 ||
+                  signed_param <= 0))) {
+                fprintf(state->err_stream,
+                        "%s: The '%s' transformation %s.\n",
+                        state->name,
+                        g_transform_names[i].name,
+                        g_transform_names[i].has_param
+                          ? "needs an integer argument greater than zero"
+                          : "doesn't accept an argument");
+                argp_usage(state);
+            }
+
+            append_transform(state,
+                             parsed_args,
+                             g_transform_names[i].type,
+                             signed_param);
+        } break;
+
         case LONGOPT_TRANSFORM_SQUARES: {
             int signed_side;
             if (sscanf(arg, "%d", &signed_side) != 1 || signed_side <= 0) {
@@ -390,11 +798,14 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
                         state->name);
                 argp_usage(state);
             }
-            parsed_args->transform_squares_side = signed_side;
+            append_transform(state,
+                             parsed_args,
+                             ARGS_TRANSFORM_SQUARES,
+                             signed_side);
         } break;
 
         case LONGOPT_TRANSFORM_ZIGZAG: {
-            parsed_args->transform_zigzag = true;
+            append_transform(state, parsed_args, ARGS_TRANSFORM_ZIGZAG, 0);
         } break;
 
         case LONGOPT_TRANSFORM_HILBERT: {
@@ -406,7 +817,35 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
                         state->name);
                 argp_usage(state);
             }
-            parsed_args->transform_hilbert_level = signed_level;
+            append_transform(state,
+                             parsed_args,
+                             ARGS_TRANSFORM_HILBERT,
+                             signed_level);
+        } break;
+
+        case LONGOPT_TRANSFORM_MORTON: {
+            int signed_level;
+            if (sscanf(arg, "%d", &signed_level) != 1 || signed_level <= 0) {
+                fprintf(state->err_stream,
+                        "%s: The Morton curve recursion level must be an "
+                        "integer greater than zero.\n",
+                        state->name);
+                argp_usage(state);
+            }
+            append_transform(state,
+                             parsed_args,
+                             ARGS_TRANSFORM_MORTON,
+                             signed_level);
+        } break;
+
+        case LONGOPT_LAYOUT_CACHE: {
+            if (*arg == '\0') {
+                fprintf(state->err_stream,
+                        "%s: The layout cache directory can't be empty.\n",
+                        state->name);
+                argp_usage(state);
+            }
+            parsed_args->layout_cache_dir = arg;
         } break;
 
         case LONGOPT_LIST_MODES: {
@@ -470,6 +909,47 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
                         parsed_args->offset_start);
                 argp_usage(state);
             }
+
+            /*
+             * The offsets are just a shorthand for a single region, so they
+             * can't be combined with explicit regions.
+             */
+            if (parsed_args->regions_num == 0) {
+                parsed_args->regions[0].start = parsed_args->offset_start;
+                parsed_args->regions[0].end   = parsed_args->offset_end;
+                parsed_args->regions_num      = 1;
+            } else if (parsed_args->offset_start != 0 ||
+                       parsed_args->offset_end != 0) {
+                fprintf(state->err_stream,
+                        "%s: The `--region' option can't be combined with "
+                        "`--offset-start' or `--offset-end'.\n",
+                        state->name);
+                argp_usage(state);
+            }
+
+            /* Only the modes that generate one pixel per sample downsample */
+            if ((parsed_args->max_height != 0 ||
+                 parsed_args->max_pixels != 0) &&
+                parsed_args->mode != ARGS_MODE_GRAYSCALE &&
+                parsed_args->mode != ARGS_MODE_ASCII &&
+                parsed_args->mode != ARGS_MODE_ENTROPY) {
+                fprintf(state->err_stream,
+                        "%s: The `--max-height' and `--max-pixels' options are "
+                        "not supported by the current mode (%s).\n",
+                        state->name,
+                        args_get_mode_name(parsed_args->mode));
+                argp_usage(state);
+            }
+
+            /* The tile directory is named after the output file */
+            if (parsed_args->output_format == ARGS_OUTPUT_FORMAT_DZI &&
+                strcmp(parsed_args->output_filename, "-") == 0) {
+                fprintf(state->err_stream,
+                        "%s: The `dzi' output format can't be written to the "
+                        "standard output.\n",
+                        state->name);
+                argp_usage(state);
+            }
         } break;
 
         default:
@@ -481,18 +961,24 @@ static error_t parse_opt(int key, char* arg, struct argp_state* state) {
 /*----------------------------------------------------------------------------*/
 
 void args_init(Args* args) {
-    args->input_filename          = NULL;
-    args->output_filename         = NULL;
-    args->mode                    = ARGS_MODE_ASCII;
-    args->block_size              = ARGS_DEFAULT_BLOCK_SIZE;
-    args->output_format           = ARGS_OUTPUT_FORMAT_PNG;
-    args->output_width            = ARGS_DEFAULT_OUTPUT_WIDTH;
-    args->offset_start            = 0;
-    args->offset_end              = 0;
-    args->output_zoom             = ARGS_DEFAULT_OUTPUT_ZOOM;
-    args->transform_squares_side  = 0;
-    args->transform_zigzag        = false;
-    args->transform_hilbert_level = 0;
+    args->input_filename   = NULL;
+    args->output_filename  = NULL;
+    args->mode             = ARGS_MODE_ASCII;
+    args->block_size       = ARGS_DEFAULT_BLOCK_SIZE;
+    args->kgram_size       = ARGS_DEFAULT_KGRAM_SIZE;
+    args->scale            = ARGS_SCALE_LOG;
+    args->jobs             = ARGS_DEFAULT_JOBS;
+    args->output_format    = ARGS_OUTPUT_FORMAT_PNG;
+    args->output_width     = ARGS_DEFAULT_OUTPUT_WIDTH;
+    args->max_height       = 0;
+    args->max_pixels       = 0;
+    args->offset_start     = 0;
+    args->offset_end       = 0;
+    args->regions_num      = 0;
+    args->output_zoom      = ARGS_DEFAULT_OUTPUT_ZOOM;
+    args->png_compression  = ARGS_PNG_COMPRESSION_DEFAULT;
+    args->transforms_num   = 0;
+    args->layout_cache_dir = NULL;
 }
 
 void args_parse(Args* args, int argc, char** argv) {
@@ -513,6 +999,13 @@ const char* args_get_mode_name(enum EArgsMode mode) {
     return "???";
 }
 
+const char* args_get_transform_name(enum EArgsTransform type) {
+    for (size_t i = 0; i < LENGTH(g_transform_names); i++)
+        if (g_transform_names[i].type == type)
+            return g_transform_names[i].name;
+    return "???";
+}
+
 const char* args_get_output_format_name(enum EArgsOutputFormat format) {
     for (size_t i = 0; i < LENGTH(g_output_formats); i++)
         if (g_output_formats[i].format == format)
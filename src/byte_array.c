@@ -16,14 +16,24 @@
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <assert.h>
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "include/byte_array.h"
 
 bool byte_array_init(ByteArray* array, size_t size) {
+    array->mapping      = NULL;
+    array->mapping_size = 0;
+
     array->size = size;
     array->data = calloc(array->size, sizeof(uint8_t));
     if (array->data == NULL)
@@ -32,7 +42,47 @@ bool byte_array_init(ByteArray* array, size_t size) {
     return true;
 }
 
+bool byte_array_map(ByteArray* array, int fd, size_t offset, size_t size) {
+    assert(size > 0);
+
+    /*
+     * The offset of 'mmap' must be a multiple of the page size, so we map from
+     * the previous page boundary, and skip the extra bytes at the start.
+     */
+    const long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0)
+        return false;
+    const size_t page_padding = offset % (size_t)page_size;
+
+    array->mapping_size = page_padding + size;
+    array->mapping      = mmap(NULL,
+                          array->mapping_size,
+                          PROT_READ,
+                          MAP_PRIVATE,
+                          fd,
+                          (off_t)(offset - page_padding));
+    if (array->mapping == MAP_FAILED) {
+        array->mapping      = NULL;
+        array->mapping_size = 0;
+        return false;
+    }
+
+    /*
+     * All the modes read the input from start to end, so let the kernel read
+     * ahead aggressively. This is just a hint, so errors are ignored.
+     */
+    posix_madvise(array->mapping,
+                  array->mapping_size,
+                  POSIX_MADV_SEQUENTIAL);
+
+    array->data = (uint8_t*)array->mapping + page_padding;
+    array->size = size;
+    return true;
+}
+
 bool byte_array_resize(ByteArray* array, size_t new_size) {
+    assert(array->mapping == NULL);
+
     void* new_ptr = realloc(array->data, new_size);
     if (new_ptr == NULL)
         return false;
@@ -43,7 +93,12 @@ bool byte_array_resize(ByteArray* array, size_t new_size) {
 }
 
 void byte_array_destroy(ByteArray* array) {
-    if (array->data != NULL) {
+    if (array->mapping != NULL) {
+        munmap(array->mapping, array->mapping_size);
+        array->mapping      = NULL;
+        array->mapping_size = 0;
+        array->data         = NULL;
+    } else if (array->data != NULL) {
         free(array->data);
         array->data = NULL;
     }
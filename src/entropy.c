@@ -0,0 +1,174 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h> /* log2() */
+
+#include "include/entropy.h"
+
+/*
+ * Number of independent counters used for each byte value when building a
+ * histogram. Consecutive bytes are counted on different lanes, so repetitive
+ * data (e.g. zero padding) doesn't have to wait for the previous increment of
+ * the same counter to be stored.
+ */
+#define LANES 4
+
+/*
+ * Maximum number of bytes counted into the 32-bit lanes before merging them.
+ */
+#define MAX_LANES_DATA_SIZE UINT32_MAX
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Count the occurrences of each byte in the specified data into the specified
+ * lanes, which should be initialized by the caller. The data size must not
+ * exceed 'MAX_LANES_DATA_SIZE'.
+ */
+static void count_into_lanes(const uint8_t* data,
+                             size_t data_sz,
+                             uint32_t lanes[LANES][ENTROPY_BINS]) {
+    assert(data_sz <= MAX_LANES_DATA_SIZE);
+
+    /* Read 8 bytes at a time, distributing them across the lanes */
+    size_t i = 0;
+    for (; i + 8 <= data_sz; i += 8) {
+        uint64_t word;
+        memcpy(&word, &data[i], sizeof(word));
+
+        lanes[0][(word >> 0) & 0xFF]++;
+        lanes[1][(word >> 8) & 0xFF]++;
+        lanes[2][(word >> 16) & 0xFF]++;
+        lanes[3][(word >> 24) & 0xFF]++;
+        lanes[0][(word >> 32) & 0xFF]++;
+        lanes[1][(word >> 40) & 0xFF]++;
+        lanes[2][(word >> 48) & 0xFF]++;
+        lanes[3][(word >> 56) & 0xFF]++;
+    }
+
+    for (; i < data_sz; i++)
+        lanes[0][data[i]]++;
+}
+
+/*
+ * Sum 'n*log2(n)' for the total occurrences of each byte value, adding the
+ * counters of all lanes.
+ */
+static double sum_nlogn(const EntropyTable* table,
+                        uint32_t lanes[LANES][ENTROPY_BINS]) {
+    double result = 0.0;
+    for (int byte = 0; byte < ENTROPY_BINS; byte++) {
+        const size_t occurrences = (size_t)lanes[0][byte] + lanes[1][byte] +
+                                   lanes[2][byte] + lanes[3][byte];
+        result += entropy_table_get(table, occurrences);
+    }
+    return result;
+}
+
+/*----------------------------------------------------------------------------*/
+
+bool entropy_table_init(EntropyTable* table, size_t block_size) {
+    table->size = block_size + 1;
+    if (table->size > ENTROPY_MAX_TABLE_SIZE)
+        table->size = ENTROPY_MAX_TABLE_SIZE;
+
+    table->nlogn = malloc(table->size * sizeof(double));
+    if (table->nlogn == NULL)
+        return false;
+
+    /* By definition, '0*log2(0)' is zero when calculating the entropy */
+    table->nlogn[0] = 0.0;
+    for (size_t n = 1; n < table->size; n++)
+        table->nlogn[n] = (double)n * log2((double)n);
+
+    return true;
+}
+
+void entropy_table_deinit(EntropyTable* table) {
+    free(table->nlogn);
+    table->nlogn = NULL;
+    table->size  = 0;
+}
+
+void entropy_count_bytes(const void* data,
+                         size_t data_sz,
+                         size_t occurrences[ENTROPY_BINS]) {
+    const uint8_t* bytes = data;
+    uint32_t lanes[LANES][ENTROPY_BINS];
+
+    /* Count in segments that can't overflow the 32-bit lanes */
+    while (data_sz > 0) {
+        const size_t segment_sz =
+          (data_sz < MAX_LANES_DATA_SIZE) ? data_sz : MAX_LANES_DATA_SIZE;
+
+        memset(lanes, 0, sizeof(lanes));
+        count_into_lanes(bytes, segment_sz, lanes);
+
+        for (int byte = 0; byte < ENTROPY_BINS; byte++)
+            for (int lane = 0; lane < LANES; lane++)
+                occurrences[byte] += lanes[lane][byte];
+
+        bytes += segment_sz;
+        data_sz -= segment_sz;
+    }
+}
+
+double entropy_of_block(const EntropyTable* table,
+                        const void* data,
+                        size_t data_sz) {
+    if (data_sz == 0)
+        return 0.0;
+
+    /*
+     * Very big blocks need to be counted in multiple segments, which is only
+     * supported by the generic function.
+     */
+    double sum;
+    if (data_sz > MAX_LANES_DATA_SIZE) {
+        size_t occurrences[ENTROPY_BINS] = { 0 };
+        entropy_count_bytes(data, data_sz, occurrences);
+
+        sum = 0.0;
+        for (int byte = 0; byte < ENTROPY_BINS; byte++)
+            sum += entropy_table_get(table, occurrences[byte]);
+    } else {
+        uint32_t lanes[LANES][ENTROPY_BINS];
+        memset(lanes, 0, sizeof(lanes));
+        count_into_lanes(data, data_sz, lanes);
+        sum = sum_nlogn(table, lanes);
+    }
+
+    /*
+     * The Shannon entropy is usually written as:
+     *
+     *   H = -sum(p_i * log2(p_i)),  where p_i = c_i / n
+     *
+     * Which can be rewritten in terms of the occurrences 'c_i', so that only
+     * the precomputed 'c*log2(c)' values are needed:
+     *
+     *   H = (n*log2(n) - sum(c_i * log2(c_i))) / n
+     */
+    const double result =
+      (entropy_table_get(table, data_sz) - sum) / (double)data_sz;
+    return (result > 0.0) ? result : 0.0;
+}
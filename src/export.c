@@ -0,0 +1,72 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "include/export.h"
+#include "include/args.h"
+#include "include/image.h"
+
+bool export_image_through_rows(export_rows_func_ptr_t export_rows_func,
+                               const Args* args,
+                               const Image* image,
+                               const ImagePalette* palette,
+                               FILE* output_fp) {
+    ExportStream stream = {
+        .args         = args,
+        .output_fp    = output_fp,
+        .width        = image->width,
+        .height       = image->height,
+        .rows_written = 0,
+        .format       = image->format,
+        .palette      = (image->format == IMAGE_FORMAT_INDEXED8)
+                          ? &image->palette
+                          : palette,
+        .data         = NULL,
+    };
+    return export_rows_func(&stream, image) && export_rows_func(&stream, NULL);
+}
+
+void export_build_zoomed_row(const Image* image,
+                             size_t y,
+                             int zoom,
+                             bool is_gray,
+                             uint8_t* dst) {
+    const size_t row_start = image->width * y;
+
+    if (is_gray) {
+        for (size_t x = 0; x < image->width; x++) {
+            const uint8_t value = image_get_color(image, row_start + x).r;
+            for (int rect_x = 0; rect_x < zoom; rect_x++)
+                *dst++ = value;
+        }
+        return;
+    }
+
+    for (size_t x = 0; x < image->width; x++) {
+        const Color color = image_get_color(image, row_start + x);
+        for (int rect_x = 0; rect_x < zoom; rect_x++) {
+            *dst++ = color.r;
+            *dst++ = color.g;
+            *dst++ = color.b;
+        }
+    }
+}
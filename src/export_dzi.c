@@ -0,0 +1,543 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/export.h"
+#include "include/image.h"
+#include "include/file.h"
+#include "include/parallel.h"
+#include "include/util.h"
+
+/* Width and height of each tile, in pixels */
+#define DZI_TILE_SIZE 256
+
+/*
+ * Number of tiles encoded by each job when a band of tiles is exported. Bigger
+ * values balance the work better, but use more memory.
+ */
+#define DZI_TILES_PER_JOB 2
+
+/* Suffix of the manifest filename, replaced with the tile directory suffix */
+#define DZI_MANIFEST_SUFFIX "dzi"
+#define DZI_TILES_SUFFIX    "_files"
+
+/*
+ * Level of the tile pyramid. Level 0 is a single pixel, and each level has twice
+ * the width and height of the previous one, rounding up. The last level has the
+ * size of the whole image.
+ */
+typedef struct {
+    size_t width, height;
+
+    /* Number of rows received by this level so far */
+    size_t rows_received;
+
+    /*
+     * Rows of the current band of tiles, which are exported once the band is
+     * full. The band contains 'band_rows' rows, and its first row is
+     * 'band_start'. The number of rows stored in the band is 'band_filled'.
+     */
+    Color* band;
+    size_t band_rows, band_start, band_filled;
+
+    /*
+     * Row waiting for the next one, so both can be averaged into a row of the
+     * previous level, if 'has_pending' is true.
+     */
+    Color* pending;
+    bool has_pending;
+
+    /* Buffer for building the rows of the previous level */
+    Color* down;
+} DziLevel;
+
+/*
+ * Data of each 'ExportStream' used by the Deep Zoom exporter.
+ */
+typedef struct {
+    /* Arguments used for exporting each tile as a PNG file */
+    Args tile_args;
+
+    /* Number of tiles exported at the same time, each on its own thread */
+    size_t jobs;
+
+    /* Path of the tile directory, and buffer for building the tile paths */
+    char* tiles_dir;
+    char* path;
+    size_t path_size;
+
+    DziLevel* levels;
+    size_t levels_num;
+
+    /* Buffer for the colors of a single input row */
+    Color* row;
+} DziData;
+
+/*
+ * Data passed to each tile export job.
+ */
+typedef struct {
+    const DziData* dzi;
+    size_t level;
+
+    /* Failure flag of each job, since they can't write to a shared variable */
+    bool* failed;
+} DziTileJobData;
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Get the number of levels needed for reducing an image of the specified
+ * dimensions to a single pixel, including the level with the original size.
+ */
+static size_t get_levels_num(size_t width, size_t height) {
+    const size_t max_side = (width > height) ? width : height;
+
+    size_t levels_num = 1;
+    while (((size_t)1 << (levels_num - 1)) < max_side)
+        levels_num++;
+    return levels_num;
+}
+
+/*
+ * Get the path of the tile directory from the path of the manifest, removing
+ * its ".dzi" extension, if any. The returned string must be freed by the
+ * caller.
+ */
+static char* get_tiles_dir(const char* manifest_path) {
+    size_t base_len = strlen(manifest_path);
+
+    const size_t suffix_len = strlen("." DZI_MANIFEST_SUFFIX);
+    if (base_len > suffix_len &&
+        strcmp(&manifest_path[base_len - suffix_len],
+               "." DZI_MANIFEST_SUFFIX) == 0)
+        base_len -= suffix_len;
+
+    char* result = malloc(base_len + sizeof(DZI_TILES_SUFFIX));
+    if (result == NULL)
+        return NULL;
+
+    memcpy(result, manifest_path, base_len);
+    strcpy(&result[base_len], DZI_TILES_SUFFIX);
+    return result;
+}
+
+/*
+ * Export the specified tile of the current band of a level into its own PNG
+ * file. Returns true on success, or false otherwise.
+ */
+static bool export_tile(const DziData* dzi,
+                        size_t level_idx,
+                        size_t col,
+                        size_t band_row,
+                        char* path) {
+    const DziLevel* level = &dzi->levels[level_idx];
+
+    const size_t x0     = col * DZI_TILE_SIZE;
+    const size_t y0     = band_row * DZI_TILE_SIZE;
+    const size_t width  = (level->width - x0 < DZI_TILE_SIZE)
+                            ? level->width - x0
+                            : DZI_TILE_SIZE;
+    const size_t height = (level->band_filled - y0 < DZI_TILE_SIZE)
+                            ? level->band_filled - y0
+                            : DZI_TILE_SIZE;
+
+    Image tile;
+    if (!image_init(&tile, IMAGE_FORMAT_RGB24, width, height))
+        return false;
+
+    uint8_t* dst = tile.data;
+    for (size_t y = 0; y < height; y++) {
+        const Color* src = &level->band[level->width * (y0 + y) + x0];
+        for (size_t x = 0; x < width; x++) {
+            *dst++ = src[x].r;
+            *dst++ = src[x].g;
+            *dst++ = src[x].b;
+        }
+    }
+
+    const size_t row = (level->band_start / DZI_TILE_SIZE) + band_row;
+    snprintf(path,
+             dzi->path_size,
+             "%s/%zu/%zu_%zu.png",
+             dzi->tiles_dir,
+             level_idx,
+             col,
+             row);
+
+    bool result  = false;
+    FILE* tile_fp = fopen(path, "wb");
+    if (tile_fp != NULL) {
+        result = export_png(&dzi->tile_args, &tile, tile_fp);
+        result = (fclose(tile_fp) == 0) && result;
+    }
+
+    if (!result)
+        ERR("Failed to export tile '%s'.", path);
+
+    image_deinit(&tile);
+    return result;
+}
+
+/*
+ * Export the tiles in the [start..end) range of the current band of a level.
+ * Each job builds its tile paths in its own part of the path buffer.
+ */
+static void tile_job(void* data, size_t job, size_t start, size_t end) {
+    DziTileJobData* job_data = data;
+    const DziData* dzi       = job_data->dzi;
+    const DziLevel* level    = &dzi->levels[job_data->level];
+
+    const size_t cols = (level->width + DZI_TILE_SIZE - 1) / DZI_TILE_SIZE;
+    char* path        = &dzi->path[dzi->path_size * job];
+
+    for (size_t i = start; i < end; i++) {
+        if (!export_tile(dzi, job_data->level, i % cols, i / cols, path)) {
+            job_data->failed[job] = true;
+            return;
+        }
+    }
+}
+
+/*
+ * Export all the tiles in the current band of a level in parallel, and empty
+ * the band.
+ */
+static bool flush_band(DziData* dzi, size_t level_idx) {
+    DziLevel* level = &dzi->levels[level_idx];
+
+    const size_t cols = (level->width + DZI_TILE_SIZE - 1) / DZI_TILE_SIZE;
+    const size_t rows =
+      (level->band_filled + DZI_TILE_SIZE - 1) / DZI_TILE_SIZE;
+    const size_t tiles_num = cols * rows;
+
+    const size_t jobs = parallel_get_jobs(dzi->jobs, tiles_num);
+    bool* failed      = calloc(jobs, sizeof(bool));
+    if (failed == NULL) {
+        ERR("Failed to allocate the tile job flags.");
+        return false;
+    }
+
+    DziTileJobData job_data = {
+        .dzi    = dzi,
+        .level  = level_idx,
+        .failed = failed,
+    };
+    parallel_for(jobs, tiles_num, tile_job, &job_data);
+
+    bool result = true;
+    for (size_t i = 0; i < jobs; i++)
+        if (failed[i])
+            result = false;
+    free(failed);
+
+    level->band_start += level->band_filled;
+    level->band_filled = 0;
+    return result;
+}
+
+/*
+ * Average the specified rows of a level into a row of the previous level. The
+ * 'bottom' row can be NULL if 'top' is the last row of an odd-sized level.
+ */
+static void downsample_rows(const DziLevel* level,
+                            const Color* top,
+                            const Color* bottom,
+                            Color* dst) {
+    const size_t dst_width = (level->width + 1) / 2;
+
+    for (size_t x = 0; x < dst_width; x++) {
+        unsigned r = 0, g = 0, b = 0, count = 0;
+
+        for (size_t src_x = x * 2; src_x < x * 2 + 2; src_x++) {
+            if (src_x >= level->width)
+                break;
+
+            r += top[src_x].r;
+            g += top[src_x].g;
+            b += top[src_x].b;
+            count++;
+
+            if (bottom != NULL) {
+                r += bottom[src_x].r;
+                g += bottom[src_x].g;
+                b += bottom[src_x].b;
+                count++;
+            }
+        }
+
+        dst[x].r = (r + count / 2) / count;
+        dst[x].g = (g + count / 2) / count;
+        dst[x].b = (b + count / 2) / count;
+    }
+}
+
+/*
+ * Add a row to the specified level, exporting its band if it's full, and
+ * averaging each pair of rows into the previous level.
+ */
+static bool push_row(DziData* dzi, size_t level_idx, const Color* row) {
+    DziLevel* level = &dzi->levels[level_idx];
+    assert(level->rows_received < level->height);
+
+    memcpy(&level->band[level->width * level->band_filled],
+           row,
+           level->width * sizeof(Color));
+    level->band_filled++;
+    level->rows_received++;
+
+    if ((level->band_filled == level->band_rows ||
+         level->rows_received == level->height) &&
+        !flush_band(dzi, level_idx))
+        return false;
+
+    /* The first level has no previous level */
+    if (level_idx == 0)
+        return true;
+
+    if (!level->has_pending) {
+        memcpy(level->pending, row, level->width * sizeof(Color));
+        level->has_pending = true;
+        return true;
+    }
+
+    downsample_rows(level, level->pending, row, level->down);
+    level->has_pending = false;
+    return push_row(dzi, level_idx - 1, level->down);
+}
+
+/*
+ * Push the rows that are still pending because the height of their level is
+ * odd. Since each level can push a row into the previous one, this is done from
+ * the last level to the first one.
+ */
+static bool push_pending_rows(DziData* dzi) {
+    for (size_t i = dzi->levels_num - 1; i > 0; i--) {
+        DziLevel* level = &dzi->levels[i];
+        if (!level->has_pending)
+            continue;
+
+        downsample_rows(level, level->pending, NULL, level->down);
+        level->has_pending = false;
+        if (!push_row(dzi, i - 1, level->down))
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ * Free the format-specific data of the stream.
+ */
+static void dzi_end(ExportStream* stream) {
+    DziData* data = stream->data;
+
+    if (data->levels != NULL) {
+        for (size_t i = 0; i < data->levels_num; i++) {
+            free(data->levels[i].band);
+            free(data->levels[i].pending);
+            free(data->levels[i].down);
+        }
+        free(data->levels);
+    }
+
+    free(data->tiles_dir);
+    free(data->path);
+    free(data->row);
+    free(data);
+    stream->data = NULL;
+}
+
+/*
+ * Initialize the specified level, allocating its buffers.
+ */
+static bool level_init(DziLevel* level,
+                       size_t width,
+                       size_t height,
+                       size_t jobs) {
+    level->width         = width;
+    level->height        = height;
+    level->rows_received = 0;
+    level->band_start    = 0;
+    level->band_filled   = 0;
+    level->has_pending   = false;
+
+    /*
+     * Each band should contain enough tiles for all jobs, without exceeding
+     * the height of the level.
+     */
+    const size_t cols = (width + DZI_TILE_SIZE - 1) / DZI_TILE_SIZE;
+    size_t band_tile_rows = (jobs * DZI_TILES_PER_JOB + cols - 1) / cols;
+    if (band_tile_rows < 1)
+        band_tile_rows = 1;
+
+    level->band_rows = band_tile_rows * DZI_TILE_SIZE;
+    if (level->band_rows > height)
+        level->band_rows = height;
+
+    level->band    = malloc(width * level->band_rows * sizeof(Color));
+    level->pending = malloc(width * sizeof(Color));
+    level->down    = malloc((width + 1) / 2 * sizeof(Color));
+    return level->band != NULL && level->pending != NULL &&
+           level->down != NULL;
+}
+
+/*
+ * Allocate the format-specific data of the stream, and create the directories
+ * of all the levels.
+ */
+static bool dzi_begin(ExportStream* stream) {
+    DziData* data = calloc(1, sizeof(DziData));
+    if (data == NULL) {
+        ERR("Failed to allocate the Deep Zoom stream data.");
+        return false;
+    }
+    stream->data = data;
+
+    /*
+     * Each tile is exported on a single thread, without any zoom, but multiple
+     * tiles are exported in parallel.
+     */
+    data->tile_args             = *stream->args;
+    data->tile_args.output_zoom = 1;
+    data->tile_args.jobs        = 1;
+
+    const size_t jobs = parallel_get_jobs(stream->args->jobs, (size_t)-1);
+    data->jobs        = jobs;
+
+    /*
+     * The tile paths have the form "DIR/LEVEL/COL_ROW.png", and each number has
+     * at most 20 digits.
+     */
+    data->tiles_dir = get_tiles_dir(stream->args->output_filename);
+    data->path_size =
+      (data->tiles_dir == NULL) ? 0 : strlen(data->tiles_dir) + 70;
+    data->path = malloc(jobs * data->path_size);
+    data->row  = malloc(stream->width * sizeof(Color));
+    if (data->tiles_dir == NULL || data->path == NULL || data->row == NULL) {
+        ERR("Failed to allocate the Deep Zoom buffers.");
+        dzi_end(stream);
+        return false;
+    }
+
+    data->levels_num = get_levels_num(stream->width, stream->height);
+    data->levels     = calloc(data->levels_num, sizeof(DziLevel));
+    if (data->levels == NULL) {
+        ERR("Failed to allocate the Deep Zoom levels.");
+        dzi_end(stream);
+        return false;
+    }
+
+    if (!file_make_dir(data->tiles_dir)) {
+        ERR("Failed to create the tile directory '%s'.", data->tiles_dir);
+        dzi_end(stream);
+        return false;
+    }
+
+    for (size_t i = 0; i < data->levels_num; i++) {
+        const size_t shift  = data->levels_num - 1 - i;
+        const size_t width  = ((stream->width - 1) >> shift) + 1;
+        const size_t height = ((stream->height - 1) >> shift) + 1;
+        if (!level_init(&data->levels[i], width, height, jobs)) {
+            ERR("Failed to allocate the buffers of level %zu.", i);
+            dzi_end(stream);
+            return false;
+        }
+
+        snprintf(data->path, data->path_size, "%s/%zu", data->tiles_dir, i);
+        if (!file_make_dir(data->path)) {
+            ERR("Failed to create the level directory '%s'.", data->path);
+            dzi_end(stream);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Write the XML manifest describing the pyramid into the output file.
+ */
+static bool write_manifest(const ExportStream* stream) {
+    const int written =
+      fprintf(stream->output_fp,
+              "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+              "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\"\n"
+              "       Format=\"png\" Overlap=\"0\" TileSize=\"%d\">\n"
+              "    <Size Width=\"%zu\" Height=\"%zu\"/>\n"
+              "</Image>\n",
+              DZI_TILE_SIZE,
+              stream->width,
+              stream->height);
+    return written >= 0 && fflush(stream->output_fp) == 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+bool export_dzi_rows(ExportStream* stream, const Image* rows) {
+    if (stream->data == NULL && !dzi_begin(stream))
+        return false;
+
+    DziData* data = stream->data;
+
+    if (rows == NULL) {
+        bool result = stream->rows_written == stream->height &&
+                      push_pending_rows(data);
+
+        for (size_t i = 0; result && i < data->levels_num; i++)
+            assert(data->levels[i].rows_received == data->levels[i].height);
+
+        result = result && write_manifest(stream);
+        if (!result)
+            ERR("Failed to write the Deep Zoom image.");
+
+        dzi_end(stream);
+        return result;
+    }
+
+    assert(rows->width == stream->width);
+    assert(stream->rows_written + rows->height <= stream->height);
+
+    /* Rows of the input image are added to the last level */
+    for (size_t y = 0; y < rows->height; y++) {
+        for (size_t x = 0; x < rows->width; x++)
+            data->row[x] = image_get_color(rows, rows->width * y + x);
+
+        if (!push_row(data, data->levels_num - 1, data->row)) {
+            dzi_end(stream);
+            return false;
+        }
+    }
+
+    stream->rows_written += rows->height;
+    return true;
+}
+
+bool export_dzi(const Args* args, const Image* image, FILE* output_fp) {
+    return export_image_through_rows(export_dzi_rows,
+                                     args,
+                                     image,
+                                     NULL,
+                                     output_fp);
+}
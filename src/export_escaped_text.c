@@ -1,37 +1,282 @@
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "include/export.h"
 #include "include/image.h"
 #include "include/util.h"
 
 /*
- * Print an empty ASCII character with the specified RGB background to the
- * specified file.
+ * Maximum length of the escape sequence for setting a 24-bit color, like
+ * "\033[48;2;255;255;255m".
  */
-static void print_ascii_color(FILE* fp, Color color, int zoom) {
-    /* Set the background character */
-    fprintf(fp, "\033[48;2;%d;%d;%dm", color.r, color.g, color.b);
+#define ESC_COLOR_MAX_SIZE 19
 
-    /* Print N empty characters, with a different background color */
-    for (int i = 0; i < zoom; i++)
-        fputc(' ', fp);
+/* Sequence for resetting the colors at the end of each line */
+#define ESC_RESET "\033[0m"
 
-    /* Reset the color for future calls */
-    fputs("\033[0m", fp);
-}
+/* Upper half block character ("▀"), encoded in UTF-8 */
+#define UPPER_HALF_BLOCK      "\xE2\x96\x80"
+#define UPPER_HALF_BLOCK_SIZE 3
+
+/*
+ * Data of each 'ExportStream' used by the escaped text exporters.
+ */
+typedef struct {
+    /* Whether each line contains two rows of pixels, using half blocks */
+    bool half_blocks;
+
+    /* Buffer for building each line before writing it */
+    char* line;
+
+    /*
+     * In half block mode, colors of the row drawn in the top half of the next
+     * line, if 'has_top' is true.
+     */
+    Color* top;
+    bool has_top;
+} EscapedTextData;
 
 /*----------------------------------------------------------------------------*/
 
-bool export_escaped_text(const Args* args, const Image* image, FILE* output_fp) {
-    for (size_t y = 0; y < image->height; y++) {
-        for (size_t x = 0; x < image->width; x++) {
-            const Color color = image->pixels[image->width * y + x];
-            print_ascii_color(output_fp, color, args->output_zoom);
+/*
+ * Write the decimal representation of a byte into the specified buffer. Returns
+ * a pointer to the end of the written number.
+ */
+static inline char* append_decimal(char* dst, uint8_t value) {
+    if (value >= 100)
+        *dst++ = '0' + value / 100;
+    if (value >= 10)
+        *dst++ = '0' + value / 10 % 10;
+    *dst++ = '0' + value % 10;
+    return dst;
+}
+
+/*
+ * Write the escape sequence for setting the background or foreground color into
+ * the specified buffer. Returns a pointer to the end of the written sequence.
+ *
+ * This is called for most pixels, so it avoids the overhead of 'sprintf'.
+ */
+static inline char* append_color(char* dst, bool background, Color color) {
+    memcpy(dst, background ? "\033[48;2;" : "\033[38;2;", 7);
+    dst += 7;
+    dst    = append_decimal(dst, color.r);
+    *dst++ = ';';
+    dst    = append_decimal(dst, color.g);
+    *dst++ = ';';
+    dst    = append_decimal(dst, color.b);
+    *dst++ = 'm';
+    return dst;
+}
+
+/*
+ * Write a line with a single row of pixels, each drawn as 'zoom' empty
+ * characters with the pixel color in the background. The color is only set
+ * when it changes.
+ */
+static void write_full_line(const ExportStream* stream,
+                            const Image* rows,
+                            size_t y) {
+    const EscapedTextData* data = stream->data;
+    const int zoom              = stream->args->output_zoom;
+
+    char* end = data->line;
+    Color prev = { 0x00, 0x00, 0x00 };
+    for (size_t x = 0; x < rows->width; x++) {
+        const Color color = image_get_color(rows, rows->width * y + x);
+        if (x == 0 || !colors_equal(color, prev))
+            end = append_color(end, true, color);
+        prev = color;
+
+        memset(end, ' ', zoom);
+        end += zoom;
+    }
+
+    /* Reset the color for the next lines */
+    end += sprintf(end, ESC_RESET "\n");
+    fwrite(data->line, 1, end - data->line, stream->output_fp);
+}
+
+/*
+ * Write a line with two rows of pixels, drawing the top one as the foreground
+ * of an upper half block, and the bottom one as its background. If 'bottom' is
+ * NULL, the bottom half uses the default background of the terminal.
+ *
+ * If both halves have the same color, an empty character is used instead, so
+ * the foreground color doesn't need to change.
+ */
+static void write_half_line(const ExportStream* stream,
+                            const Color* top,
+                            const Color* bottom) {
+    const EscapedTextData* data = stream->data;
+    const int zoom              = stream->args->output_zoom;
+
+    /* Colors set by the previous escape sequences of this line */
+    Color fg = { 0x00, 0x00, 0x00 }, bg = { 0x00, 0x00, 0x00 };
+    bool has_fg = false, has_bg = false;
+
+    char* end = data->line;
+    for (size_t x = 0; x < stream->width; x++) {
+        const bool is_solid =
+          (bottom != NULL && colors_equal(top[x], bottom[x]));
+
+        if (!is_solid && (!has_fg || !colors_equal(fg, top[x]))) {
+            end    = append_color(end, false, top[x]);
+            fg     = top[x];
+            has_fg = true;
+        }
+        if (bottom != NULL && (!has_bg || !colors_equal(bg, bottom[x]))) {
+            end    = append_color(end, true, bottom[x]);
+            bg     = bottom[x];
+            has_bg = true;
+        }
+
+        for (int i = 0; i < zoom; i++) {
+            if (is_solid) {
+                *end++ = ' ';
+            } else {
+                memcpy(end, UPPER_HALF_BLOCK, UPPER_HALF_BLOCK_SIZE);
+                end += UPPER_HALF_BLOCK_SIZE;
+            }
         }
-        fputc('\n', output_fp);
     }
 
+    end += sprintf(end, ESC_RESET "\n");
+    fwrite(data->line, 1, end - data->line, stream->output_fp);
+}
+
+/*
+ * Add the specified row to the half block output. Since each line contains two
+ * rows, a line is only written once its bottom row is received.
+ */
+static void add_half_row(const ExportStream* stream, const Color* row) {
+    EscapedTextData* data = stream->data;
+
+    if (!data->has_top) {
+        memcpy(data->top, row, stream->width * sizeof(Color));
+        data->has_top = true;
+        return;
+    }
+
+    write_half_line(stream, data->top, row);
+    data->has_top = false;
+}
+
+/*
+ * Allocate the format-specific data of the stream, including a buffer big
+ * enough for the longest possible line.
+ */
+static bool escaped_text_begin(ExportStream* stream, bool half_blocks) {
+    EscapedTextData* data = calloc(1, sizeof(EscapedTextData));
+    if (data == NULL) {
+        ERR("Failed to allocate the escaped text stream data.");
+        return false;
+    }
+    data->half_blocks = half_blocks;
+
+    /* Each pixel can change both colors, and it's followed by its characters */
+    const size_t zoom      = stream->args->output_zoom;
+    const size_t cell_size = half_blocks ? zoom * UPPER_HALF_BLOCK_SIZE : zoom;
+    const size_t line_size =
+      stream->width * (2 * ESC_COLOR_MAX_SIZE + cell_size) +
+      sizeof(ESC_RESET "\n");
+
+    data->line = malloc(line_size);
+    if (half_blocks)
+        data->top = malloc(2 * stream->width * sizeof(Color));
+    if (data->line == NULL || (half_blocks && data->top == NULL)) {
+        ERR("Failed to allocate the escaped text line buffers.");
+        free(data->line);
+        free(data->top);
+        free(data);
+        return false;
+    }
+
+    stream->data = data;
+    return true;
+}
+
+/*
+ * Finish the output, and free the format-specific data of the stream.
+ */
+static void escaped_text_end(ExportStream* stream) {
+    EscapedTextData* data = stream->data;
+
+    /* Write the last row, if it doesn't have a bottom row */
+    if (data->half_blocks && data->has_top)
+        write_half_line(stream, data->top, NULL);
+
+    free(data->line);
+    free(data->top);
+    free(data);
+    stream->data = NULL;
+}
+
+/*
+ * Export the next rows of an image, with one or two rows of pixels per line.
+ */
+static bool escaped_text_rows(ExportStream* stream,
+                              const Image* rows,
+                              bool half_blocks) {
+    if (stream->data == NULL && !escaped_text_begin(stream, half_blocks))
+        return false;
+
+    if (rows == NULL) {
+        escaped_text_end(stream);
+        return true;
+    }
+
+    const EscapedTextData* data = stream->data;
+
+    for (size_t y = 0; y < rows->height; y++) {
+        if (!half_blocks) {
+            write_full_line(stream, rows, y);
+            continue;
+        }
+
+        /*
+         * The second half of the 'top' buffer holds the colors of the current
+         * row. Like in the full lines, the zoom is only applied horizontally,
+         * so each pair of consecutive rows is drawn in a single line.
+         */
+        Color* row = &data->top[stream->width];
+        for (size_t x = 0; x < rows->width; x++)
+            row[x] = image_get_color(rows, rows->width * y + x);
+        add_half_row(stream, row);
+    }
+
+    stream->rows_written += rows->height;
     return true;
 }
+
+/*----------------------------------------------------------------------------*/
+
+bool export_escaped_text_rows(ExportStream* stream, const Image* rows) {
+    return escaped_text_rows(stream, rows, false);
+}
+
+bool export_escaped_text_half_rows(ExportStream* stream, const Image* rows) {
+    return escaped_text_rows(stream, rows, true);
+}
+
+bool export_escaped_text(const Args* args, const Image* image, FILE* output_fp) {
+    return export_image_through_rows(export_escaped_text_rows,
+                                     args,
+                                     image,
+                                     NULL,
+                                     output_fp);
+}
+
+bool export_escaped_text_half(const Args* args,
+                              const Image* image,
+                              FILE* output_fp) {
+    return export_image_through_rows(export_escaped_text_half_rows,
+                                     args,
+                                     image,
+                                     NULL,
+                                     output_fp);
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <zlib.h>
+
+#include "include/export.h"
+#include "include/image.h"
+#include "include/util.h"
+
+/*
+ * Number of compressed bytes sent in each escape sequence. The protocol allows
+ * up to 4096 bytes of base64 data in each chunk, which encode 3072 bytes.
+ */
+#define KITTY_CHUNK_SIZE 3072
+
+/* Size of the base64 encoding of a full chunk */
+#define KITTY_ENCODED_SIZE (KITTY_CHUNK_SIZE / 3 * 4)
+
+/*
+ * Data of each 'ExportStream' used by the kitty exporter.
+ */
+typedef struct {
+    /* Stream for compressing the RGB pixels */
+    z_stream strm;
+
+    /* Buffer for a single zoomed row of RGB pixels */
+    uint8_t* row;
+    size_t row_size;
+
+    /* Compressed bytes of the current chunk, and their base64 encoding */
+    uint8_t chunk[KITTY_CHUNK_SIZE];
+    size_t chunk_filled;
+    char encoded[KITTY_ENCODED_SIZE];
+
+    /* Whether the first chunk, with the image parameters, was written */
+    bool sent_first;
+} KittyData;
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Encode the specified bytes in base64, with padding. Returns the number of
+ * written characters.
+ */
+static size_t base64_encode(const uint8_t* src, size_t size, char* dst) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                   "abcdefghijklmnopqrstuvwxyz"
+                                   "0123456789+/";
+
+    char* start = dst;
+    size_t i    = 0;
+    for (; i + 3 <= size; i += 3) {
+        const uint32_t bits = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+        *dst++              = alphabet[(bits >> 18) & 0x3F];
+        *dst++              = alphabet[(bits >> 12) & 0x3F];
+        *dst++              = alphabet[(bits >> 6) & 0x3F];
+        *dst++              = alphabet[bits & 0x3F];
+    }
+
+    if (i < size) {
+        const bool has_second = (i + 1 < size);
+        const uint32_t bits =
+          (src[i] << 16) | (has_second ? src[i + 1] << 8 : 0);
+        *dst++ = alphabet[(bits >> 18) & 0x3F];
+        *dst++ = alphabet[(bits >> 12) & 0x3F];
+        *dst++ = has_second ? alphabet[(bits >> 6) & 0x3F] : '=';
+        *dst++ = '=';
+    }
+
+    return dst - start;
+}
+
+/*
+ * Write the current chunk as an escape sequence of the graphics protocol. The
+ * first chunk also contains the parameters of the image, and 'is_last'
+ * indicates whether more chunks will follow.
+ */
+static bool write_chunk(const ExportStream* stream, bool is_last) {
+    KittyData* data = stream->data;
+    const int more  = is_last ? 0 : 1;
+    const int zoom  = stream->args->output_zoom;
+
+    /*
+     * Transmit and display 24-bit RGB pixels, compressed with zlib, without
+     * any response from the terminal.
+     */
+    int written;
+    if (!data->sent_first)
+        written = fprintf(stream->output_fp,
+                          "\033_Ga=T,f=24,o=z,q=2,s=%zu,v=%zu,m=%d;",
+                          stream->width * zoom,
+                          stream->height * zoom,
+                          more);
+    else
+        written = fprintf(stream->output_fp, "\033_Gm=%d;", more);
+
+    const size_t size =
+      base64_encode(data->chunk, data->chunk_filled, data->encoded);
+    if (written < 0 ||
+        fwrite(data->encoded, 1, size, stream->output_fp) != size ||
+        fputs("\033\\", stream->output_fp) == EOF)
+        return false;
+
+    data->sent_first   = true;
+    data->chunk_filled = 0;
+    return true;
+}
+
+/*
+ * Compress the specified bytes, writing each full chunk of compressed data
+ * once more data is known to follow it. If 'flush' is 'Z_FINISH', the stream
+ * is finished and the last chunk is written.
+ */
+static bool compress_bytes(const ExportStream* stream,
+                           const uint8_t* src,
+                           size_t size,
+                           int flush) {
+    KittyData* data = stream->data;
+
+    data->strm.next_in  = (uint8_t*)src;
+    data->strm.avail_in = size;
+
+    int ret;
+    do {
+        if (data->chunk_filled == KITTY_CHUNK_SIZE &&
+            !write_chunk(stream, false))
+            return false;
+
+        data->strm.next_out  = &data->chunk[data->chunk_filled];
+        data->strm.avail_out = KITTY_CHUNK_SIZE - data->chunk_filled;
+
+        ret = deflate(&data->strm, flush);
+        if (ret == Z_STREAM_ERROR)
+            return false;
+
+        data->chunk_filled = KITTY_CHUNK_SIZE - data->strm.avail_out;
+    } while (data->strm.avail_in > 0 || data->strm.avail_out == 0 ||
+             (flush == Z_FINISH && ret != Z_STREAM_END));
+
+    return flush != Z_FINISH || write_chunk(stream, true);
+}
+
+/*
+ * Allocate the format-specific data of the stream, and initialize the
+ * compression stream.
+ */
+static bool kitty_begin(ExportStream* stream) {
+    KittyData* data = calloc(1, sizeof(KittyData));
+    if (data == NULL) {
+        ERR("Failed to allocate the kitty stream data.");
+        return false;
+    }
+
+    data->row_size = stream->width * stream->args->output_zoom * 3;
+    data->row      = malloc(data->row_size);
+    if (data->row == NULL) {
+        ERR("Failed to allocate the kitty row buffer.");
+        free(data);
+        return false;
+    }
+
+    if (deflateInit(&data->strm, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        ERR("Failed to initialize the kitty compression stream.");
+        free(data->row);
+        free(data);
+        return false;
+    }
+
+    stream->data = data;
+    return true;
+}
+
+/*
+ * Free the format-specific data of the stream.
+ */
+static void kitty_end(ExportStream* stream) {
+    KittyData* data = stream->data;
+    deflateEnd(&data->strm);
+    free(data->row);
+    free(data);
+    stream->data = NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+
+bool export_kitty_rows(ExportStream* stream, const Image* rows) {
+    if (stream->data == NULL && !kitty_begin(stream))
+        return false;
+
+    KittyData* data = stream->data;
+
+    if (rows == NULL) {
+        /* Move the cursor below the image, like the other text formats */
+        const bool result = stream->rows_written == stream->height &&
+                            compress_bytes(stream, NULL, 0, Z_FINISH) &&
+                            fputc('\n', stream->output_fp) != EOF &&
+                            fflush(stream->output_fp) == 0;
+        if (!result)
+            ERR("Failed to write all the rows of the kitty image.");
+        kitty_end(stream);
+        return result;
+    }
+
+    assert(rows->width == stream->width && rows->format == stream->format);
+    assert(stream->rows_written + rows->height <= stream->height);
+
+    const int zoom = stream->args->output_zoom;
+    for (size_t y = 0; y < rows->height; y++) {
+        /* Build the zoomed row once, and compress it 'zoom' times */
+        export_build_zoomed_row(rows, y, zoom, false, data->row);
+
+        for (int rect_y = 0; rect_y < zoom; rect_y++) {
+            if (!compress_bytes(stream, data->row, data->row_size, Z_NO_FLUSH)) {
+                ERR("Failed to write the kitty image rows.");
+                kitty_end(stream);
+                return false;
+            }
+        }
+    }
+
+    stream->rows_written += rows->height;
+    return true;
+}
+
+bool export_kitty(const Args* args, const Image* image, FILE* output_fp) {
+    return export_image_through_rows(export_kitty_rows,
+                                     args,
+                                     image,
+                                     NULL,
+                                     output_fp);
+}
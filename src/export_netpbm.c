@@ -0,0 +1,214 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "include/export.h"
+#include "include/image.h"
+#include "include/util.h"
+
+/*
+ * Data of each 'ExportStream' used by the Netpbm exporters.
+ */
+typedef struct {
+    /* Whether the output has a single gray channel, instead of RGB */
+    bool is_gray;
+
+    /* Buffer for a single zoomed row, in the output format */
+    uint8_t* row;
+    size_t row_size;
+} NetpbmData;
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Check if all the pixels of the stream can be exported as a single gray
+ * channel without losing information.
+ */
+static bool stream_is_gray(const ExportStream* stream) {
+    switch (stream->format) {
+        case IMAGE_FORMAT_GRAY8:
+            return true;
+
+        case IMAGE_FORMAT_INDEXED8:
+            for (size_t i = 0; i < stream->palette->size; i++) {
+                const Color color = stream->palette->colors[i];
+                if (color.r != color.g || color.r != color.b)
+                    return false;
+            }
+            return true;
+
+        case IMAGE_FORMAT_RGB24:
+        default:
+            return false;
+    }
+}
+
+/*
+ * Write the header of the output file, and allocate the format-specific data
+ * of the stream. If 'is_pam' is false, a PPM file is written, which only
+ * supports RGB pixels.
+ */
+static bool netpbm_begin(ExportStream* stream, bool is_pam) {
+    NetpbmData* data = malloc(sizeof(NetpbmData));
+    if (data == NULL) {
+        ERR("Failed to allocate the Netpbm stream data.");
+        return false;
+    }
+
+    const size_t zoom   = stream->args->output_zoom;
+    const size_t width  = stream->width * zoom;
+    const size_t height = stream->height * zoom;
+
+    data->is_gray  = is_pam && stream_is_gray(stream);
+    data->row_size = width * (data->is_gray ? 1 : 3);
+    data->row      = malloc(data->row_size);
+    if (data->row == NULL) {
+        ERR("Failed to allocate the Netpbm row buffer.");
+        free(data);
+        return false;
+    }
+
+    int written;
+    if (is_pam)
+        written = fprintf(stream->output_fp,
+                          "P7\n"
+                          "WIDTH %zu\n"
+                          "HEIGHT %zu\n"
+                          "DEPTH %d\n"
+                          "MAXVAL 255\n"
+                          "TUPLTYPE %s\n"
+                          "ENDHDR\n",
+                          width,
+                          height,
+                          data->is_gray ? 1 : 3,
+                          data->is_gray ? "GRAYSCALE" : "RGB");
+    else
+        written = fprintf(stream->output_fp,
+                          "P6\n%zu %zu\n255\n",
+                          width,
+                          height);
+
+    if (written < 0) {
+        ERR("Failed to write the Netpbm header.");
+        free(data->row);
+        free(data);
+        return false;
+    }
+
+    stream->data = data;
+    return true;
+}
+
+/*
+ * Free the format-specific data of the stream.
+ */
+static void netpbm_end(ExportStream* stream) {
+    NetpbmData* data = stream->data;
+    free(data->row);
+    free(data);
+    stream->data = NULL;
+}
+
+/*
+ * Export the next rows of an image into a PPM or PAM file.
+ */
+static bool netpbm_rows(ExportStream* stream, const Image* rows, bool is_pam) {
+    if (stream->data == NULL && !netpbm_begin(stream, is_pam))
+        return false;
+
+    if (rows == NULL) {
+        const bool result = stream->rows_written == stream->height &&
+                            fflush(stream->output_fp) == 0;
+        if (!result)
+            ERR("Failed to write all the rows of the Netpbm image.");
+        netpbm_end(stream);
+        return result;
+    }
+
+    assert(rows->width == stream->width && rows->format == stream->format);
+    assert(stream->rows_written + rows->height <= stream->height);
+
+    const NetpbmData* data = stream->data;
+    const int zoom         = stream->args->output_zoom;
+
+    /*
+     * If the pixels are already stored in the output format, write all of them
+     * at once.
+     */
+    const bool same_layout =
+      (data->is_gray) ? rows->format == IMAGE_FORMAT_GRAY8
+                      : rows->format == IMAGE_FORMAT_RGB24;
+    if (zoom == 1 && same_layout) {
+        const size_t size = data->row_size * rows->height;
+        if (fwrite(rows->data, 1, size, stream->output_fp) != size) {
+            ERR("Failed to write the Netpbm image rows.");
+            netpbm_end(stream);
+            return false;
+        }
+
+        stream->rows_written += rows->height;
+        return true;
+    }
+
+    /* Otherwise, build each zoomed row once, and write it 'zoom' times */
+    for (size_t y = 0; y < rows->height; y++) {
+        export_build_zoomed_row(rows, y, zoom, data->is_gray, data->row);
+        for (int rect_y = 0; rect_y < zoom; rect_y++) {
+            if (fwrite(data->row, 1, data->row_size, stream->output_fp) !=
+                data->row_size) {
+                ERR("Failed to write the Netpbm image rows.");
+                netpbm_end(stream);
+                return false;
+            }
+        }
+    }
+
+    stream->rows_written += rows->height;
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+bool export_ppm_rows(ExportStream* stream, const Image* rows) {
+    return netpbm_rows(stream, rows, false);
+}
+
+bool export_pam_rows(ExportStream* stream, const Image* rows) {
+    return netpbm_rows(stream, rows, true);
+}
+
+bool export_ppm(const Args* args, const Image* image, FILE* output_fp) {
+    return export_image_through_rows(export_ppm_rows,
+                                     args,
+                                     image,
+                                     NULL,
+                                     output_fp);
+}
+
+bool export_pam(const Args* args, const Image* image, FILE* output_fp) {
+    return export_image_through_rows(export_pam_rows,
+                                     args,
+                                     image,
+                                     NULL,
+                                     output_fp);
+}
@@ -16,109 +16,1058 @@
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #include <png.h>
+#include <zlib.h>
 
 #include "include/export.h"
 #include "include/image.h"
-#include "include/byte_array.h"
+#include "include/parallel.h"
 #include "include/util.h"
 
-/* Bytes per pixel of the PNG image (R, G, B) */
-#define PNG_BPP 3
+/*
+ * Minimum size of the uncompressed image data for using the parallel encoder,
+ * and approximate size of the uncompressed data in each of its stripes.
+ */
+#define PNG_PARALLEL_MIN_SIZE 0x200000
+#define PNG_STRIPE_SIZE       0x100000
+
+/*
+ * Number of stripes compressed by each thread before writing them, which
+ * limits the amount of compressed data kept in memory.
+ */
+#define PNG_STRIPES_PER_JOB 4
+
+/* Size of the deflate window, and therefore maximum size of a dictionary */
+#define DEFLATE_WINDOW_SIZE 0x8000
+
+/*
+ * Filters and compression level used for each 'EArgsPngCompression' preset.
+ * The filters are a mask of 'PNG_FILTER_*' values, like the ones received by
+ * 'png_set_filter'. If more than one filter is specified, the one with the
+ * lowest sum of absolute differences is used for each row.
+ */
+static const struct {
+    int filters;
+    int level;
+} g_png_compression_presets[] = {
+    [ARGS_PNG_COMPRESSION_FAST]    = { PNG_FILTER_SUB | PNG_FILTER_UP, 1 },
+    [ARGS_PNG_COMPRESSION_DEFAULT] = { PNG_ALL_FILTERS, 6 },
+    [ARGS_PNG_COMPRESSION_BEST]    = { PNG_ALL_FILTERS, 9 },
+};
+
+/*
+ * Pixel format of the PNG image, which depends on the colors of the image.
+ */
+typedef struct {
+    int color_type; /* PNG_COLOR_TYPE_* */
+    int bit_depth;
+
+    /* Bytes per complete pixel, rounded up to one, used by the filters */
+    size_t bpp;
+
+    /* Size in bytes of a single zoomed row, without the filter type */
+    size_t row_size;
+
+    /* Mask of 'PNG_FILTER_*' values used for the rows */
+    int filters;
+
+    /* Colors of the image, only used with 'PNG_COLOR_TYPE_PALETTE' */
+    const ImagePalette* palette;
+
+    /* Value of each byte, for images with single-byte pixels */
+    uint8_t values[UCHAR_MAX + 1];
+} PngFormat;
+
+/*
+ * Compressed data of a group of consecutive rows, used by the parallel
+ * encoder.
+ */
+typedef struct {
+    /*
+     * First row and number of rows in the stripe, after applying the zoom, and
+     * relative to the rows received by 'export_png_rows'.
+     */
+    size_t first_row, rows_num;
+
+    /* Compressed data, in raw deflate format */
+    uint8_t* data;
+    size_t size, capacity;
+
+    /* Adler-32 checksum and size of the uncompressed data */
+    uLong adler;
+    size_t raw_size;
+
+    bool success;
+} PngStripe;
+
+/*
+ * Format-specific data of an 'ExportStream' used by 'export_png_rows'.
+ */
+typedef struct {
+    PngFormat format;
+
+    /*
+     * The libpng structures, only used if the image is not compressed on
+     * multiple threads.
+     */
+    png_structp png;
+    png_infop info;
+
+    /* Buffer for a single zoomed row, reused for every row */
+    png_bytep row;
+
+    /*
+     * Data used when the image is compressed on multiple threads. The 'jobs'
+     * member is zero if libpng is used instead.
+     */
+    size_t jobs;
+    PngStripe* stripes;
+
+    /* Adler-32 checksum of all the uncompressed data written so far */
+    uLong adler;
+
+    /*
+     * Last zoomed row received in the previous call, and the last bytes of
+     * uncompressed data, used as the dictionary of the next rows.
+     */
+    bool has_prev_row;
+    png_bytep prev_row;
+    uint8_t window[DEFLATE_WINDOW_SIZE];
+    size_t window_size;
+} PngStreamData;
+
+/*
+ * Data shared by all the threads of 'png_parallel_write_rows'.
+ */
+typedef struct {
+    const ExportStream* stream;
+    const Image* rows;
+    PngStripe* stripes;
+} PngStripeJobData;
+
+/*----------------------------------------------------------------------------*/
 
 bool export_png(const Args* args, const Image* image, FILE* output_fp) {
-    png_structp png =
+    /*
+     * Export the whole image as a single group of rows, so each zoomed row is
+     * built once into a single buffer, instead of allocating a zoomed copy of
+     * the whole image.
+     */
+    /*
+     * If the image has few colors, it can be exported in a smaller format.
+     * Indexed images are exported with their own palette, since their pixels
+     * are already indexes.
+     */
+    ImagePalette palette;
+    const bool has_palette = image->format != IMAGE_FORMAT_INDEXED8 &&
+                             image_get_palette(image, &palette);
+
+    return export_image_through_rows(export_png_rows,
+                                     args,
+                                     image,
+                                     has_palette ? &palette : NULL,
+                                     output_fp);
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Initialize the pixel format for exporting the images of the specified stream,
+ * whose palette can be NULL if the colors are not known.
+ *
+ * If all colors are gray, the image is exported in grayscale, with a single bit
+ * per pixel if all of them are black or white. Otherwise, if the palette is
+ * known, the image is exported with the smallest indexed format.
+ */
+static void png_format_init(PngFormat* format,
+                            const ExportStream* stream) {
+    const ImagePalette* palette = stream->palette;
+    const size_t png_width      = stream->width * stream->args->output_zoom;
+
+    bool is_gray   = (stream->format == IMAGE_FORMAT_GRAY8);
+    bool is_binary = false;
+    if (palette != NULL) {
+        is_gray = is_binary = true;
+        for (size_t i = 0; i < palette->size; i++) {
+            const Color color = palette->colors[i];
+            if (color.r != color.g || color.r != color.b)
+                is_gray = false;
+            if (color.r != 0x00 && color.r != 0xFF)
+                is_binary = false;
+        }
+    }
+
+    format->palette = NULL;
+    if (is_gray) {
+        format->color_type = PNG_COLOR_TYPE_GRAY;
+        format->bit_depth  = is_binary ? 1 : 8;
+    } else if (palette != NULL) {
+        format->color_type = PNG_COLOR_TYPE_PALETTE;
+        format->bit_depth  = (palette->size <= 2)    ? 1
+                             : (palette->size <= 4)  ? 2
+                             : (palette->size <= 16) ? 4
+                                                     : 8;
+        format->palette    = palette;
+    } else {
+        format->color_type = PNG_COLOR_TYPE_RGB;
+        format->bit_depth  = 8;
+    }
+
+    const int channels = (format->color_type == PNG_COLOR_TYPE_RGB) ? 3 : 1;
+    const size_t bits  = (size_t)channels * format->bit_depth;
+    format->bpp        = (bits < 8) ? 1 : bits / 8;
+    format->row_size   = (png_width * bits + 7) / 8;
+
+    /*
+     * As recommended by the PNG specification, don't filter indexed images or
+     * images with less than 8 bits per pixel.
+     */
+    format->filters =
+      (format->color_type == PNG_COLOR_TYPE_PALETTE || format->bit_depth < 8)
+        ? PNG_FILTER_NONE
+        : g_png_compression_presets[stream->args->png_compression].filters;
+
+    /*
+     * For single-byte pixels, the PNG value of each pixel only depends on its
+     * byte. Indexed images are written with their own palette, so the indexes
+     * don't change.
+     */
+    if (stream->format == IMAGE_FORMAT_RGB24)
+        return;
+    for (int byte = 0; byte <= UCHAR_MAX; byte++) {
+        if (format->color_type == PNG_COLOR_TYPE_PALETTE)
+            format->values[byte] = (byte < (int)palette->size) ? byte : 0;
+        else if (stream->format == IMAGE_FORMAT_GRAY8)
+            format->values[byte] = byte >> (8 - format->bit_depth);
+        else if (byte < (int)palette->size)
+            format->values[byte] =
+              palette->colors[byte].r >> (8 - format->bit_depth);
+        else
+            format->values[byte] = 0;
+    }
+}
+
+/*
+ * Get the PNG value of an RGB pixel in a single-channel format.
+ */
+static inline int rgb_pixel_value(const PngFormat* format, Color color) {
+    if (format->color_type != PNG_COLOR_TYPE_PALETTE)
+        return color.r >> (8 - format->bit_depth);
+
+    const int value = image_palette_find(format->palette, color);
+    return (value < 0) ? 0 : value;
+}
+
+/*
+ * Write the specified row of an 'Image' into a PNG row with the specified
+ * format, scaling it horizontally by the specified zoom.
+ */
+static void build_zoomed_row(const PngFormat* format,
+                             const Image* image,
+                             size_t y,
+                             int zoom,
+                             uint8_t* dst) {
+    const size_t row_start = image->width * y;
+    const Color* pixels    = (const Color*)image->data + row_start;
+    const uint8_t* bytes   = &image->data[row_start];
+
+    /* Note that we are using RGB, not RGBA */
+    if (format->color_type == PNG_COLOR_TYPE_RGB) {
+        assert(image->format == IMAGE_FORMAT_RGB24);
+        export_build_zoomed_row(image, y, zoom, false, dst);
+        return;
+    }
+
+    /*
+     * Single-channel formats. The pixels are packed starting from the most
+     * significant bit of each byte.
+     */
+    const int depth = format->bit_depth;
+    if (depth < 8)
+        memset(dst, 0, format->row_size);
+
+    for (size_t x = 0; x < image->width; x++) {
+        const int value = (image->format == IMAGE_FORMAT_RGB24)
+                            ? rgb_pixel_value(format, pixels[x])
+                            : format->values[bytes[x]];
+
+        for (int rect_x = 0; rect_x < zoom; rect_x++) {
+            const size_t bit = (zoom * x + rect_x) * depth;
+            if (depth == 8)
+                dst[bit / 8] = value;
+            else
+                dst[bit / 8] |= value << (8 - depth - bit % 8);
+        }
+    }
+}
+
+/*
+ * Predictor used by the Paeth filter. See section 9.4 of the PNG
+ * specification.
+ */
+static inline uint8_t paeth_predictor(int a, int b, int c) {
+    const int pa = abs(b - c);
+    const int pb = abs(a - c);
+    const int pc = abs(a + b - c - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    if (pb <= pc)
+        return b;
+    return c;
+}
+
+/*
+ * Filter the bytes in the [start..end) range of a row with the specified
+ * 'PNG_FILTER_VALUE_*' filter, writing them into 'dst'. The range must not
+ * include the first pixel of the row, which has no pixel to its left, and the
+ * 'prev' row must not be NULL for the filters that use it.
+ */
+static void filter_range(int filter,
+                         size_t bpp,
+                         const uint8_t* row,
+                         const uint8_t* prev,
+                         size_t start,
+                         size_t end,
+                         uint8_t* dst) {
+    assert(start >= bpp);
+
+    switch (filter) {
+        default:
+        case PNG_FILTER_VALUE_NONE:
+            memcpy(&dst[start], &row[start], end - start);
+            break;
+
+        case PNG_FILTER_VALUE_SUB:
+            for (size_t i = start; i < end; i++)
+                dst[i] = row[i] - row[i - bpp];
+            break;
+
+        case PNG_FILTER_VALUE_UP:
+            for (size_t i = start; i < end; i++)
+                dst[i] = row[i] - prev[i];
+            break;
+
+        case PNG_FILTER_VALUE_AVG:
+            for (size_t i = start; i < end; i++)
+                dst[i] = row[i] - (row[i - bpp] + prev[i]) / 2;
+            break;
+
+        case PNG_FILTER_VALUE_PAETH:
+            for (size_t i = start; i < end; i++)
+                dst[i] = row[i] - paeth_predictor(row[i - bpp],
+                                                  prev[i],
+                                                  prev[i - bpp]);
+            break;
+    }
+}
+
+/*
+ * Sum of the absolute values of the bytes in the [start..end) range,
+ * interpreted as signed. Used for choosing the best filter.
+ */
+static inline size_t filtered_sum(const uint8_t* data,
+                                  size_t start,
+                                  size_t end) {
+    size_t sum = 0;
+    for (size_t i = start; i < end; i++)
+        sum += (data[i] < 0x80) ? data[i] : 0x100 - data[i];
+    return sum;
+}
+
+/*
+ * Filter a row of 'size' bytes with the specified 'PNG_FILTER_VALUE_*' filter,
+ * writing the filter type and the filtered bytes into 'dst'. The 'prev' row is
+ * NULL for the first row of the image.
+ *
+ * Returns the sum of the absolute values of the filtered bytes. Since it's only
+ * used for choosing the best filter, the function stops once the sum reaches
+ * 'limit', leaving the row incomplete.
+ */
+static size_t filter_row(int filter,
+                         size_t bpp,
+                         const uint8_t* row,
+                         const uint8_t* prev,
+                         size_t size,
+                         uint8_t* dst,
+                         size_t limit) {
+    /*
+     * The first row is filtered as if the previous one was zero, which turns
+     * the Up filter into None, the Average filter into a half Sub, and the
+     * Paeth filter into Sub.
+     */
+    if (prev == NULL) {
+        if (filter == PNG_FILTER_VALUE_UP)
+            filter = PNG_FILTER_VALUE_NONE;
+        else if (filter == PNG_FILTER_VALUE_PAETH)
+            filter = PNG_FILTER_VALUE_SUB;
+    }
+
+    dst[0] = filter;
+    dst++;
+
+    /* The first pixel has no pixel to its left, and all filters use 'prev' */
+    const size_t first_size = (size < bpp) ? size : bpp;
+    for (size_t i = 0; i < first_size; i++) {
+        const uint8_t up = (prev != NULL) ? prev[i] : 0;
+        switch (filter) {
+            default:
+            case PNG_FILTER_VALUE_NONE:
+            case PNG_FILTER_VALUE_SUB:
+                dst[i] = row[i];
+                break;
+            case PNG_FILTER_VALUE_UP:
+            case PNG_FILTER_VALUE_PAETH:
+                dst[i] = row[i] - up;
+                break;
+            case PNG_FILTER_VALUE_AVG:
+                dst[i] = row[i] - up / 2;
+                break;
+        }
+    }
+    size_t sum = filtered_sum(dst, 0, first_size);
+
+    /*
+     * Filter the rest of the row in blocks, so we can stop early if the sum is
+     * already too big.
+     */
+    const size_t block_size = 0x400;
+    for (size_t start = first_size; start < size && sum < limit;
+         start += block_size) {
+        const size_t end = (size - start > block_size) ? start + block_size
+                                                       : size;
+
+        if (filter == PNG_FILTER_VALUE_AVG && prev == NULL) {
+            for (size_t i = start; i < end; i++)
+                dst[i] = row[i] - row[i - bpp] / 2;
+        } else {
+            filter_range(filter, bpp, row, prev, start, end, dst);
+        }
+
+        sum += filtered_sum(dst, start, end);
+    }
+
+    return sum;
+}
+
+/*
+ * Filter a row with the filters in the specified mask, like 'filter_row'. If
+ * the mask has more than one filter, the one with the lowest sum is used. The
+ * 'tmp' buffer must be as big as 'dst', that is, 'size + 1'.
+ */
+static void filter_row_adaptive(int filters,
+                                size_t bpp,
+                                const uint8_t* row,
+                                const uint8_t* prev,
+                                size_t size,
+                                uint8_t* dst,
+                                uint8_t* tmp) {
+    size_t best_sum = SIZE_MAX;
+    for (int filter = PNG_FILTER_VALUE_NONE; filter < PNG_FILTER_VALUE_LAST;
+         filter++) {
+        if ((filters & (PNG_FILTER_NONE << filter)) == 0)
+            continue;
+
+        /*
+         * Filter into the temporary buffer, and copy it into the destination if
+         * it's the best so far.
+         */
+        const size_t sum =
+          filter_row(filter, bpp, row, prev, size, tmp, best_sum);
+        if (sum < best_sum) {
+            best_sum = sum;
+            memcpy(dst, tmp, size + 1);
+        }
+    }
+}
+
+/*
+ * Buffers used by each thread for filtering rows.
+ */
+typedef struct {
+    uint8_t* row;
+    uint8_t* prev;
+    uint8_t* tmp;
+} FilterBuffers;
+
+static bool filter_buffers_init(FilterBuffers* buffers, size_t row_size) {
+    buffers->row  = malloc(row_size);
+    buffers->prev = malloc(row_size);
+    buffers->tmp  = malloc(row_size + 1);
+    return buffers->row != NULL && buffers->prev != NULL &&
+           buffers->tmp != NULL;
+}
+
+static void filter_buffers_deinit(FilterBuffers* buffers) {
+    free(buffers->row);
+    free(buffers->prev);
+    free(buffers->tmp);
+}
+
+/*
+ * Filter the zoomed row 'y' of the received rows into 'dst', which must be able
+ * to hold the filter type and the row bytes. The first row is filtered using
+ * the last row of the previous call, if any.
+ */
+static void filter_stream_row(const ExportStream* stream,
+                              const Image* rows,
+                              size_t y,
+                              FilterBuffers* buffers,
+                              uint8_t* dst) {
+    const PngStreamData* data = stream->data;
+    const PngFormat* format   = &data->format;
+    const int zoom            = stream->args->output_zoom;
+
+    const uint8_t* prev = NULL;
+    if (y > 0) {
+        build_zoomed_row(format, rows, (y - 1) / zoom, zoom, buffers->prev);
+        prev = buffers->prev;
+    } else if (data->has_prev_row) {
+        prev = data->prev_row;
+    }
+
+    build_zoomed_row(format, rows, y / zoom, zoom, buffers->row);
+    filter_row_adaptive(format->filters,
+                        format->bpp,
+                        buffers->row,
+                        prev,
+                        format->row_size,
+                        dst,
+                        buffers->tmp);
+}
+
+/*
+ * Get the last bytes of uncompressed data before the zoomed row 'y' of the
+ * received rows, up to the size of the deflate window, including the data of
+ * the previous calls. The 'dst' buffer must be able to hold the window plus the
+ * filtered rows that fit in it, and the returned pointer is inside that buffer.
+ */
+static const uint8_t* build_dictionary(const ExportStream* stream,
+                                       const Image* rows,
+                                       size_t y,
+                                       FilterBuffers* buffers,
+                                       uint8_t* dst,
+                                       size_t* dict_size) {
+    const PngStreamData* data = stream->data;
+    const size_t line_size    = data->format.row_size + 1;
+    const size_t dict_rows = (DEFLATE_WINDOW_SIZE + line_size - 1) / line_size;
+    const size_t first     = (y > dict_rows) ? y - dict_rows : 0;
+
+    /* If the rows don't fill the window, start with the previous data */
+    size_t size = 0;
+    if (first == 0) {
+        memcpy(dst, data->window, data->window_size);
+        size = data->window_size;
+    }
+
+    for (size_t i = first; i < y; i++) {
+        filter_stream_row(stream, rows, i, buffers, &dst[size]);
+        size += line_size;
+    }
+
+    *dict_size = (size > DEFLATE_WINDOW_SIZE) ? DEFLATE_WINDOW_SIZE : size;
+    return &dst[size - *dict_size];
+}
+
+/*
+ * Compress the rows of a single stripe into a raw deflate stream, ending with a
+ * sync flush so the stripes can be concatenated.
+ *
+ * Like in 'pigz', the last data before the stripe is used as the dictionary, so
+ * the stripes can be compressed independently without losing much compression
+ * ratio.
+ */
+static bool compress_stripe(const ExportStream* stream,
+                            const Image* rows,
+                            PngStripe* stripe) {
+    const PngFormat* format = &((const PngStreamData*)stream->data)->format;
+    const size_t row_size   = format->row_size;
+    const size_t line_size  = row_size + 1;
+    const int level =
+      g_png_compression_presets[stream->args->png_compression].level;
+
+    bool result       = false;
+    bool strm_is_init = false;
+    z_stream strm     = { 0 };
+
+    FilterBuffers buffers;
+    uint8_t* line = malloc(line_size);
+    uint8_t* dict = malloc(2 * DEFLATE_WINDOW_SIZE + line_size);
+    if (!filter_buffers_init(&buffers, row_size) || line == NULL ||
+        dict == NULL)
+        goto done;
+
+    /* Like libpng, use the strategy for filtered data if rows are filtered */
+    const int strategy =
+      (format->filters == PNG_FILTER_NONE) ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+    if (deflateInit2(&strm, level, Z_DEFLATED, -15, 8, strategy) != Z_OK)
+        goto done;
+    strm_is_init = true;
+
+    size_t dict_size;
+    const uint8_t* dict_start = build_dictionary(stream,
+                                                 rows,
+                                                 stripe->first_row,
+                                                 &buffers,
+                                                 dict,
+                                                 &dict_size);
+    if (dict_size > 0 &&
+        deflateSetDictionary(&strm, dict_start, dict_size) != Z_OK)
+        goto done;
+
+    stripe->capacity = deflateBound(&strm, stripe->rows_num * line_size) + 16;
+    stripe->data     = malloc(stripe->capacity);
+    if (stripe->data == NULL)
+        goto done;
+
+    strm.next_out  = stripe->data;
+    strm.avail_out = stripe->capacity;
+
+    stripe->adler    = adler32(0, NULL, 0);
+    stripe->raw_size = 0;
+    for (size_t i = 0; i < stripe->rows_num; i++) {
+        filter_stream_row(stream, rows, stripe->first_row + i, &buffers, line);
+        stripe->adler = adler32(stripe->adler, line, line_size);
+        stripe->raw_size += line_size;
+
+        const int flush = (i + 1 == stripe->rows_num) ? Z_SYNC_FLUSH
+                                                     : Z_NO_FLUSH;
+        strm.next_in  = line;
+        strm.avail_in = line_size;
+        do {
+            /* Grow the output buffer if needed */
+            if (strm.avail_out == 0) {
+                const size_t used = stripe->capacity;
+                uint8_t* new_data = realloc(stripe->data, used * 2);
+                if (new_data == NULL)
+                    goto done;
+                stripe->data     = new_data;
+                stripe->capacity = used * 2;
+                strm.next_out    = &stripe->data[used];
+                strm.avail_out   = stripe->capacity - used;
+            }
+
+            const int ret = deflate(&strm, flush);
+            if (ret != Z_OK && ret != Z_BUF_ERROR)
+                goto done;
+        } while (strm.avail_in > 0 ||
+                 (flush != Z_NO_FLUSH && strm.avail_out == 0));
+    }
+
+    stripe->size = stripe->capacity - strm.avail_out;
+    result       = true;
+
+done:
+    if (strm_is_init)
+        deflateEnd(&strm);
+    free(dict);
+    free(line);
+    filter_buffers_deinit(&buffers);
+    return result;
+}
+
+/*
+ * Compress the stripes in the [start..end) range.
+ */
+static void stripe_job(void* data, size_t job, size_t start, size_t end) {
+    UNUSED(job);
+    const PngStripeJobData* ctx = data;
+
+    for (size_t i = start; i < end; i++)
+        ctx->stripes[i].success =
+          compress_stripe(ctx->stream, ctx->rows, &ctx->stripes[i]);
+}
+
+/*
+ * Write a 32-bit big-endian integer, as used in the PNG format.
+ */
+static inline void write_be32(uint8_t* dst, uint32_t value) {
+    dst[0] = (value >> 24) & 0xFF;
+    dst[1] = (value >> 16) & 0xFF;
+    dst[2] = (value >> 8) & 0xFF;
+    dst[3] = value & 0xFF;
+}
+
+/*
+ * Write a PNG chunk with the specified type and data into the output file.
+ */
+static bool write_chunk(FILE* fp,
+                        const char* type,
+                        const uint8_t* data,
+                        size_t size) {
+    uint8_t header[8];
+    write_be32(&header[0], size);
+    memcpy(&header[4], type, 4);
+
+    uLong crc = crc32(0, NULL, 0);
+    crc       = crc32(crc, &header[4], 4);
+    if (size > 0)
+        crc = crc32(crc, data, size);
+
+    uint8_t footer[4];
+    write_be32(footer, crc);
+
+    return fwrite(header, sizeof(header), 1, fp) == 1 &&
+           (size == 0 || fwrite(data, size, 1, fp) == 1) &&
+           fwrite(footer, sizeof(footer), 1, fp) == 1;
+}
+
+/*
+ * Write the PNG signature, the header chunk, and the header of the zlib stream
+ * that will contain the concatenated stripes.
+ */
+static bool png_parallel_begin(const ExportStream* stream) {
+    const PngFormat* format = &((const PngStreamData*)stream->data)->format;
+    const int zoom          = stream->args->output_zoom;
+
+    static const uint8_t signature[8] = { 0x89, 'P',  'N',  'G',
+                                          '\r', '\n', 0x1A, '\n' };
+
+    uint8_t ihdr[13];
+    write_be32(&ihdr[0], stream->width * zoom);
+    write_be32(&ihdr[4], stream->height * zoom);
+    ihdr[8]  = format->bit_depth;
+    ihdr[9]  = format->color_type;
+    ihdr[10] = PNG_COMPRESSION_TYPE_DEFAULT;
+    ihdr[11] = PNG_FILTER_TYPE_DEFAULT;
+    ihdr[12] = PNG_INTERLACE_NONE;
+
+    /*
+     * Deflate with a 32KiB window, and a hint of the compression level. The
+     * check bits make the header a multiple of 31.
+     */
+    const int level =
+      g_png_compression_presets[stream->args->png_compression].level;
+    const int level_hint = (level <= 1)   ? 0
+                           : (level <= 5) ? 1
+                           : (level == 6) ? 2
+                                          : 3;
+    uint8_t zlib_header[2] = { 0x78, level_hint << 6 };
+    zlib_header[1] += (31 - ((zlib_header[0] << 8) | zlib_header[1]) % 31) % 31;
+
+    if (fwrite(signature, sizeof(signature), 1, stream->output_fp) != 1 ||
+        !write_chunk(stream->output_fp, "IHDR", ihdr, sizeof(ihdr)))
+        return false;
+
+    /* The palette chunk, with the RGB values of each entry */
+    if (format->color_type == PNG_COLOR_TYPE_PALETTE) {
+        uint8_t plte[3 * IMAGE_PALETTE_MAX_SIZE];
+        for (size_t i = 0; i < format->palette->size; i++) {
+            plte[3 * i]     = format->palette->colors[i].r;
+            plte[3 * i + 1] = format->palette->colors[i].g;
+            plte[3 * i + 2] = format->palette->colors[i].b;
+        }
+        if (!write_chunk(stream->output_fp,
+                         "PLTE",
+                         plte,
+                         3 * format->palette->size))
+            return false;
+    }
+
+    return write_chunk(stream->output_fp,
+                       "IDAT",
+                       zlib_header,
+                       sizeof(zlib_header));
+}
+
+/*
+ * Filter and compress the received rows in stripes on multiple threads, and
+ * write each compressed stripe as a separate data chunk.
+ */
+static bool png_parallel_write_rows(ExportStream* stream, const Image* rows) {
+    PngStreamData* data    = stream->data;
+    const int zoom         = stream->args->output_zoom;
+    const size_t row_size  = data->format.row_size;
+    const size_t line_size = row_size + 1;
+    const size_t rows_num  = rows->height * zoom;
+
+    size_t stripe_rows = PNG_STRIPE_SIZE / line_size;
+    if (stripe_rows < 1)
+        stripe_rows = 1;
+    const size_t batch_size = data->jobs * PNG_STRIPES_PER_JOB;
+
+    bool result = true;
+    for (size_t row = 0; result && row < rows_num;) {
+        /* Prepare the next batch of stripes */
+        size_t stripes_num = 0;
+        for (; stripes_num < batch_size && row < rows_num; stripes_num++) {
+            PngStripe* stripe = &data->stripes[stripes_num];
+            stripe->first_row = row;
+            stripe->rows_num  = stripe_rows;
+            if (stripe->rows_num > rows_num - row)
+                stripe->rows_num = rows_num - row;
+            stripe->data = NULL;
+            row += stripe->rows_num;
+        }
+
+        PngStripeJobData job_data = {
+            .stream  = stream,
+            .rows    = rows,
+            .stripes = data->stripes,
+        };
+        parallel_for(data->jobs, stripes_num, stripe_job, &job_data);
+
+        for (size_t i = 0; i < stripes_num; i++) {
+            PngStripe* stripe = &data->stripes[i];
+            if (result && !stripe->success) {
+                ERR("Failed to compress PNG rows.");
+                result = false;
+            }
+
+            if (result) {
+                data->adler = adler32_combine(data->adler,
+                                              stripe->adler,
+                                              stripe->raw_size);
+                result      = write_chunk(stream->output_fp,
+                                     "IDAT",
+                                     stripe->data,
+                                     stripe->size);
+                if (!result)
+                    ERR("Failed to write PNG data.");
+            }
+
+            free(stripe->data);
+            stripe->data = NULL;
+        }
+    }
+    if (!result)
+        return false;
+
+    /*
+     * Store the data needed by the first rows of the next call: the end of the
+     * uncompressed data, and the last zoomed row.
+     */
+    FilterBuffers buffers;
+    uint8_t* dict = malloc(2 * DEFLATE_WINDOW_SIZE + line_size);
+    if (!filter_buffers_init(&buffers, row_size) || dict == NULL) {
+        ERR("Failed to allocate PNG dictionary.");
+        filter_buffers_deinit(&buffers);
+        free(dict);
+        return false;
+    }
+
+    size_t dict_size;
+    const uint8_t* dict_start =
+      build_dictionary(stream, rows, rows_num, &buffers, dict, &dict_size);
+    memcpy(data->window, dict_start, dict_size);
+    data->window_size = dict_size;
+
+    build_zoomed_row(&data->format,
+                     rows,
+                     rows->height - 1,
+                     zoom,
+                     data->prev_row);
+    data->has_prev_row = true;
+
+    filter_buffers_deinit(&buffers);
+    free(dict);
+    return true;
+}
+
+/*
+ * Finish the zlib stream with an empty final block and the checksum of all the
+ * uncompressed data, and write the end chunk.
+ */
+static bool png_parallel_end(const ExportStream* stream) {
+    const PngStreamData* data = stream->data;
+
+    uint8_t zlib_footer[6] = { 0x03, 0x00 };
+    write_be32(&zlib_footer[2], data->adler);
+
+    if (!write_chunk(stream->output_fp,
+                     "IDAT",
+                     zlib_footer,
+                     sizeof(zlib_footer)) ||
+        !write_chunk(stream->output_fp, "IEND", NULL, 0)) {
+        ERR("Failed to write PNG data.");
+        return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Free the data of a PNG 'ExportStream', along with the structure itself.
+ */
+static void png_stream_data_free(PngStreamData* data) {
+    if (data == NULL)
+        return;
+    if (data->png != NULL)
+        png_destroy_write_struct(&data->png, &data->info);
+    free(data->row);
+    free(data->prev_row);
+    free(data->stripes);
+    free(data);
+}
+
+/*
+ * Initialize the 'data' member of the specified 'ExportStream' for encoding the
+ * image on multiple threads, and write the PNG header into the output file.
+ */
+static bool png_stream_begin_parallel(ExportStream* stream,
+                                      PngStreamData* data) {
+    data->stripes =
+      calloc(data->jobs * PNG_STRIPES_PER_JOB, sizeof(PngStripe));
+    data->prev_row = malloc(data->format.row_size);
+    if (data->stripes == NULL || data->prev_row == NULL) {
+        ERR("Failed to allocate PNG stream data.");
+        return false;
+    }
+
+    data->adler        = adler32(0, NULL, 0);
+    data->has_prev_row = false;
+    data->window_size  = 0;
+
+    stream->data = data;
+    if (!png_parallel_begin(stream)) {
+        ERR("Failed to write the PNG header.");
+        stream->data = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Initialize the 'data' member of the specified 'ExportStream' for encoding the
+ * image with libpng, and write the PNG header into the output file.
+ */
+static bool png_stream_begin_libpng(ExportStream* stream, PngStreamData* data) {
+    const int zoom          = stream->args->output_zoom;
+    const size_t png_height = stream->height * zoom;
+    const size_t png_width  = stream->width * zoom;
+
+    data->png =
       png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (png == NULL) {
+    if (data->png == NULL) {
         ERR("Can't create 'png_structp'.");
         return false;
     }
 
-    png_infop info = png_create_info_struct(png);
-    if (info == NULL) {
+    data->info = png_create_info_struct(data->png);
+    if (data->info == NULL) {
         ERR("Can't create 'png_infop'.");
         return false;
     }
 
-    /* The actual PNG image dimensions, remember that the Image is unscaled */
-    assert(image->height > 0 && image->width > 0);
-    const int zoom          = args->output_zoom;
-    const size_t png_height = image->height * zoom;
-    const size_t png_width  = image->width * zoom;
+    data->row = malloc(data->format.row_size);
+    if (data->row == NULL) {
+        ERR("Failed to allocate PNG row.");
+        return false;
+    }
 
-    /* Specify the PNG info */
-    png_init_io(png, output_fp);
-    png_set_IHDR(png,
-                 info,
+    png_init_io(data->png, stream->output_fp);
+    png_set_IHDR(data->png,
+                 data->info,
                  png_width,
                  png_height,
-                 8,
-                 PNG_COLOR_TYPE_RGB,
+                 data->format.bit_depth,
+                 data->format.color_type,
                  PNG_INTERLACE_NONE,
                  PNG_COMPRESSION_TYPE_DEFAULT,
                  PNG_FILTER_TYPE_DEFAULT);
-    png_write_info(png, info);
+    if (data->format.color_type == PNG_COLOR_TYPE_PALETTE) {
+        const ImagePalette* palette = data->format.palette;
+        png_color plte[IMAGE_PALETTE_MAX_SIZE];
+        for (size_t i = 0; i < palette->size; i++) {
+            plte[i].red   = palette->colors[i].r;
+            plte[i].green = palette->colors[i].g;
+            plte[i].blue  = palette->colors[i].b;
+        }
+        png_set_PLTE(data->png, data->info, plte, palette->size);
+    }
+    png_set_filter(data->png, PNG_FILTER_TYPE_DEFAULT, data->format.filters);
+    png_set_compression_level(
+      data->png,
+      g_png_compression_presets[stream->args->png_compression].level);
+    png_write_info(data->png, data->info);
 
-    /*
-     * Allocate the PNG rows. Since 'png_bytep' is typedef'd to a pointer, this
-     * is a (void**).
-     */
-    png_bytep* rows = calloc(png_height, sizeof(png_bytep));
-    if (rows == NULL) {
-        ERR("Failed to allocate PNG rows array.");
+    stream->data = data;
+    return true;
+}
+
+/*
+ * Initialize the 'data' member of the specified 'ExportStream', and write the
+ * PNG header into the output file. If the image is big enough, it will be
+ * filtered and compressed on multiple threads, otherwise libpng is used.
+ */
+static bool png_stream_begin(ExportStream* stream) {
+    assert(stream->width > 0 && stream->height > 0);
+    const int zoom          = stream->args->output_zoom;
+
+    PngStreamData* data = calloc(1, sizeof(PngStreamData));
+    if (data == NULL) {
+        ERR("Failed to allocate PNG stream data.");
         return false;
     }
 
-    for (size_t y = 0; y < png_height; y++) {
-        rows[y] = malloc(png_width * PNG_BPP);
-        if (rows[y] == NULL) {
-            ERR("Failed to allocate PNG row #%zu.", y);
-            return false;
-        }
-    }
+    png_format_init(&data->format, stream);
+    const size_t line_size = data->format.row_size + 1;
+    const size_t raw_size  = stream->height * zoom * line_size;
 
-    /*
-     * Write the 'bytes' array we received into the 'rows' array we just
-     * allocated.
-     *
-     * The outer loops iterate the unscaled pixels, and are needed for accessing
-     * the 'bytes->data' array.
-     */
-    for (size_t y = 0; y < image->height; y++) {
-        for (size_t x = 0; x < image->width; x++) {
-            const Color color = image->pixels[image->width * y + x];
-
-            /* Draw a rectangle of side 'zoom' */
-            for (int rect_y = 0; rect_y < zoom; rect_y++) {
-                for (int rect_x = 0; rect_x < zoom; rect_x++) {
-                    assert(y * zoom + rect_y < png_height);
-                    const png_bytep row = rows[zoom * y + rect_y];
-
-                    /* Note that we are using RGB, not RGBA */
-                    row[PNG_BPP * (zoom * x + rect_x)]     = color.r;
-                    row[PNG_BPP * (zoom * x + rect_x) + 1] = color.g;
-                    row[PNG_BPP * (zoom * x + rect_x) + 2] = color.b;
-                }
-            }
-        }
-    }
+    data->jobs =
+      parallel_get_jobs(stream->args->jobs, raw_size / PNG_STRIPE_SIZE + 1);
+    if (data->jobs <= 1 || raw_size < PNG_PARALLEL_MIN_SIZE)
+        data->jobs = 0;
+
+    const bool result = (data->jobs > 0)
+                          ? png_stream_begin_parallel(stream, data)
+                          : png_stream_begin_libpng(stream, data);
+    if (!result)
+        png_stream_data_free(data);
+
+    return result;
+}
+
+bool export_png_rows(ExportStream* stream, const Image* rows) {
+    if (stream->data == NULL && !png_stream_begin(stream))
+        return false;
+
+    PngStreamData* data = stream->data;
+    const int zoom      = stream->args->output_zoom;
 
-    /* Write the rows into the PNG structure */
-    png_write_image(png, rows);
-    png_write_end(png, NULL);
+    if (rows == NULL) {
+        bool result = stream->rows_written == stream->height;
+        if (!result)
+            ERR("Expected %zu rows for the PNG image, but received %zu.",
+                stream->height,
+                stream->rows_written);
+        else if (data->jobs > 0)
+            result = png_parallel_end(stream);
+        else
+            png_write_end(data->png, NULL);
+
+        png_stream_data_free(data);
+        stream->data = NULL;
+        return result;
+    }
 
-    /* Free each pointer of the 'rows' array, and the array itself */
-    for (size_t y = 0; y < png_height; y++)
-        free(rows[y]);
-    free(rows);
+    assert(rows->width == stream->width && rows->format == stream->format);
+    assert(stream->rows_written + rows->height <= stream->height);
 
-    png_destroy_write_struct(&png, &info);
+    if (data->jobs > 0) {
+        if (!png_parallel_write_rows(stream, rows)) {
+            png_stream_data_free(data);
+            stream->data = NULL;
+            return false;
+        }
+    } else {
+        for (size_t y = 0; y < rows->height; y++) {
+            /* Build the zoomed row once, and write it 'zoom' times */
+            build_zoomed_row(&data->format, rows, y, zoom, data->row);
+            for (int rect_y = 0; rect_y < zoom; rect_y++)
+                png_write_row(data->png, data->row);
+        }
+    }
 
+    stream->rows_written += rows->height;
     return true;
 }
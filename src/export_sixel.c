@@ -0,0 +1,351 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/export.h"
+#include "include/image.h"
+#include "include/util.h"
+
+/* Number of pixel rows in each sixel band */
+#define SIXEL_BAND_HEIGHT 6
+
+/* Number of levels of each channel in the color cube used for RGB images */
+#define SIXEL_CUBE_LEVELS 6
+
+/*
+ * Maximum length of the sequences written for each color of a band, besides
+ * its sixels: the color selection, the repeated empty sixels before its first
+ * pixel, and the carriage return.
+ */
+#define SIXEL_COLOR_OVERHEAD 32
+
+/* Sequences for starting and finishing the sixel image */
+#define SIXEL_BEGIN "\033Pq"
+#define SIXEL_END   "\033\\\n"
+
+/*
+ * Data of each 'ExportStream' used by the sixel exporter.
+ */
+typedef struct {
+    /* Width of the zoomed image, in pixels */
+    size_t width;
+
+    /* Number of color registers used by the image */
+    size_t colors_num;
+
+    /* Register of each byte, for gray and indexed images */
+    uint8_t registers[UCHAR_MAX + 1];
+
+    /* Registers of the current zoomed row */
+    uint8_t* row;
+
+    /*
+     * Sixels of each color in the current band, with a bit for each of its
+     * rows, and the range of columns that contain each color.
+     */
+    uint8_t* sixels;
+    size_t min_x[IMAGE_PALETTE_MAX_SIZE];
+    size_t max_x[IMAGE_PALETTE_MAX_SIZE];
+
+    /* Number of rows in the current band */
+    size_t band_filled;
+
+    /* Buffer for the sixels of a single color before writing them */
+    char* out;
+} SixelData;
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Get the color register of an RGB pixel. If the stream has a palette, the
+ * index of the color is used. Otherwise, the color is approximated with a
+ * color cube.
+ */
+static inline uint8_t rgb_register(const ExportStream* stream, Color color) {
+    if (stream->palette != NULL) {
+        const int index = image_palette_find(stream->palette, color);
+        return (index < 0) ? 0 : index;
+    }
+
+    const int max = SIXEL_CUBE_LEVELS - 1;
+    const int r   = (color.r * max + UCHAR_MAX / 2) / UCHAR_MAX;
+    const int g   = (color.g * max + UCHAR_MAX / 2) / UCHAR_MAX;
+    const int b   = (color.b * max + UCHAR_MAX / 2) / UCHAR_MAX;
+    return (r * SIXEL_CUBE_LEVELS + g) * SIXEL_CUBE_LEVELS + b;
+}
+
+/*
+ * Get the color of the specified register. See 'rgb_register'.
+ */
+static Color register_color(const ExportStream* stream, size_t i) {
+    if (stream->palette != NULL)
+        return stream->palette->colors[i];
+
+    if (stream->format == IMAGE_FORMAT_GRAY8) {
+        const Color color = { i, i, i };
+        return color;
+    }
+
+    const int max     = SIXEL_CUBE_LEVELS - 1;
+    const Color color = {
+        (i / (SIXEL_CUBE_LEVELS * SIXEL_CUBE_LEVELS)) * UCHAR_MAX / max,
+        (i / SIXEL_CUBE_LEVELS % SIXEL_CUBE_LEVELS) * UCHAR_MAX / max,
+        (i % SIXEL_CUBE_LEVELS) * UCHAR_MAX / max,
+    };
+    return color;
+}
+
+/*
+ * Write the header of the sixel image, including the definition of all the
+ * color registers, and allocate the format-specific data of the stream.
+ */
+static bool sixel_begin(ExportStream* stream) {
+    SixelData* data = calloc(1, sizeof(SixelData));
+    if (data == NULL) {
+        ERR("Failed to allocate the sixel stream data.");
+        return false;
+    }
+
+    const size_t zoom = stream->args->output_zoom;
+    data->width       = stream->width * zoom;
+
+    /*
+     * Gray images without a palette use a register for each value, and RGB
+     * images without a palette use a color cube.
+     */
+    if (stream->palette != NULL)
+        data->colors_num = stream->palette->size;
+    else if (stream->format == IMAGE_FORMAT_GRAY8)
+        data->colors_num = UCHAR_MAX + 1;
+    else
+        data->colors_num =
+          SIXEL_CUBE_LEVELS * SIXEL_CUBE_LEVELS * SIXEL_CUBE_LEVELS;
+
+    /* Indexed pixels are registers, other single-byte pixels are colors */
+    for (int i = 0; i <= UCHAR_MAX; i++) {
+        if (stream->format == IMAGE_FORMAT_INDEXED8 || stream->palette == NULL)
+            data->registers[i] = i;
+        else
+            data->registers[i] =
+              rgb_register(stream, (Color){ i, i, i });
+    }
+
+    for (size_t i = 0; i < data->colors_num; i++) {
+        data->min_x[i] = SIZE_MAX;
+        data->max_x[i] = 0;
+    }
+
+    data->row    = malloc(data->width);
+    data->sixels = calloc(data->colors_num, data->width);
+    data->out    = malloc(data->width + SIXEL_COLOR_OVERHEAD);
+    if (data->row == NULL || data->sixels == NULL || data->out == NULL) {
+        ERR("Failed to allocate the sixel buffers.");
+        free(data->row);
+        free(data->sixels);
+        free(data->out);
+        free(data);
+        return false;
+    }
+
+    /*
+     * Set a pixel aspect ratio of 1:1 and the image size, and define each
+     * color register, using percentages for each channel.
+     */
+    fprintf(stream->output_fp,
+            SIXEL_BEGIN "\"1;1;%zu;%zu",
+            data->width,
+            stream->height * zoom);
+    for (size_t i = 0; i < data->colors_num; i++) {
+        const Color color = register_color(stream, i);
+        fprintf(stream->output_fp,
+                "#%zu;2;%d;%d;%d",
+                i,
+                (color.r * 100 + UCHAR_MAX / 2) / UCHAR_MAX,
+                (color.g * 100 + UCHAR_MAX / 2) / UCHAR_MAX,
+                (color.b * 100 + UCHAR_MAX / 2) / UCHAR_MAX);
+    }
+
+    stream->data = data;
+    return true;
+}
+
+/*
+ * Free the format-specific data of the stream.
+ */
+static void sixel_end(ExportStream* stream) {
+    SixelData* data = stream->data;
+    free(data->row);
+    free(data->sixels);
+    free(data->out);
+    free(data);
+    stream->data = NULL;
+}
+
+/*
+ * Append a sixel character repeated 'count' times to the specified buffer,
+ * using the repeat introducer when it's shorter. Returns a pointer to the end
+ * of the written characters.
+ */
+static inline char* append_run(char* dst, char sixel, size_t count) {
+    if (count > 3)
+        return dst + sprintf(dst, "!%zu%c", count, sixel);
+
+    while (count-- > 0)
+        *dst++ = sixel;
+    return dst;
+}
+
+/*
+ * Write the sixels of each color used in the current band, and clear them for
+ * the next band.
+ */
+static bool write_band(const ExportStream* stream) {
+    SixelData* data = stream->data;
+
+    for (size_t i = 0; i < data->colors_num; i++) {
+        if (data->min_x[i] > data->max_x[i])
+            continue;
+
+        uint8_t* sixels  = &data->sixels[data->width * i];
+        const size_t end = data->max_x[i] + 1;
+
+        /* Select the color, and skip the columns before its first pixel */
+        char* dst = data->out + sprintf(data->out, "#%zu", i);
+        dst       = append_run(dst, '?', data->min_x[i]);
+
+        size_t x = data->min_x[i];
+        while (x < end) {
+            const uint8_t bits = sixels[x];
+
+            size_t run_end = x + 1;
+            while (run_end < end && sixels[run_end] == bits)
+                run_end++;
+
+            dst = append_run(dst, '?' + bits, run_end - x);
+            memset(&sixels[x], 0, run_end - x);
+            x = run_end;
+        }
+
+        /* Return to the start of the band for the next color */
+        *dst++ = '$';
+
+        const size_t size = dst - data->out;
+        if (fwrite(data->out, 1, size, stream->output_fp) != size)
+            return false;
+
+        data->min_x[i] = SIZE_MAX;
+        data->max_x[i] = 0;
+    }
+
+    /* Move to the next band */
+    data->band_filled = 0;
+    return fputc('-', stream->output_fp) != EOF;
+}
+
+/*
+ * Add the current zoomed row to the band, writing the band if it's full.
+ */
+static bool add_row(const ExportStream* stream) {
+    SixelData* data   = stream->data;
+    const uint8_t bit = 1 << data->band_filled;
+
+    for (size_t x = 0; x < data->width; x++) {
+        const uint8_t reg = data->row[x];
+        data->sixels[data->width * reg + x] |= bit;
+
+        if (x < data->min_x[reg])
+            data->min_x[reg] = x;
+        if (x > data->max_x[reg])
+            data->max_x[reg] = x;
+    }
+
+    data->band_filled++;
+    return data->band_filled < SIXEL_BAND_HEIGHT || write_band(stream);
+}
+
+/*----------------------------------------------------------------------------*/
+
+bool export_sixel_rows(ExportStream* stream, const Image* rows) {
+    if (stream->data == NULL && !sixel_begin(stream))
+        return false;
+
+    SixelData* data = stream->data;
+
+    if (rows == NULL) {
+        /* Write the last band, even if it's not full */
+        bool result = (data->band_filled == 0 || write_band(stream)) &&
+                      fputs(SIXEL_END, stream->output_fp) != EOF &&
+                      stream->rows_written == stream->height;
+        if (!result)
+            ERR("Failed to write all the rows of the sixel image.");
+        sixel_end(stream);
+        return result;
+    }
+
+    assert(rows->width == stream->width && rows->format == stream->format);
+    assert(stream->rows_written + rows->height <= stream->height);
+
+    const int zoom = stream->args->output_zoom;
+    for (size_t y = 0; y < rows->height; y++) {
+        /* Build the zoomed row once, and add it 'zoom' times */
+        uint8_t* dst = data->row;
+        for (size_t x = 0; x < rows->width; x++) {
+            const size_t i    = rows->width * y + x;
+            const uint8_t reg = (rows->format == IMAGE_FORMAT_RGB24)
+                                  ? rgb_register(stream,
+                                                 image_get_color(rows, i))
+                                  : data->registers[rows->data[i]];
+            memset(dst, reg, zoom);
+            dst += zoom;
+        }
+
+        for (int rect_y = 0; rect_y < zoom; rect_y++) {
+            if (!add_row(stream)) {
+                ERR("Failed to write the sixel image rows.");
+                sixel_end(stream);
+                return false;
+            }
+        }
+    }
+
+    stream->rows_written += rows->height;
+    return true;
+}
+
+bool export_sixel(const Args* args, const Image* image, FILE* output_fp) {
+    /*
+     * Indexed images use their own palette, and other images use their colors
+     * as the registers, if there are few enough.
+     */
+    ImagePalette palette;
+    const bool has_palette = image->format != IMAGE_FORMAT_INDEXED8 &&
+                             image_get_palette(image, &palette);
+
+    return export_image_through_rows(export_sixel_rows,
+                                     args,
+                                     image,
+                                     has_palette ? &palette : NULL,
+                                     output_fp);
+}
@@ -16,12 +16,20 @@
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "include/file.h"
 #include "include/args.h"
 #include "include/byte_array.h"
@@ -30,6 +38,28 @@
 #define STDIN_FILENAME  "-"
 #define STDOUT_FILENAME "-"
 
+/*
+ * Size of the buffer used for discarding bytes of non-seekable files.
+ */
+#define SKIP_BUFFER_SIZE 0x10000
+
+/*
+ * Minimum and maximum sizes of each chunk used when reading files of unknown
+ * size. Each chunk doubles the size of the previous one, up to the maximum.
+ */
+#define MIN_CHUNK_SIZE 0x10000
+#define MAX_CHUNK_SIZE 0x4000000
+
+/*
+ * Node of a linked list of buffers, used for reading files of unknown size
+ * without having to copy the data each time the buffer needs to grow.
+ */
+typedef struct FileChunk {
+    uint8_t* data;
+    size_t size;
+    struct FileChunk* next;
+} FileChunk;
+
 FILE* file_open(const char* path, enum EFileOpenMode mode) {
     switch (mode) {
         case FILE_MODE_READ:
@@ -49,6 +79,250 @@ FILE* file_open(const char* path, enum EFileOpenMode mode) {
     }
 }
 
+/*
+ * Try to map the target bytes of a regular file into memory, instead of copying
+ * them. Returns true if the 'ByteArray' was initialized, or false if the file
+ * can't be mapped (e.g. because it's a pipe), in which case the file position
+ * is left untouched.
+ */
+static bool file_read_mapped(ByteArray* dst,
+                             FILE* fp,
+                             size_t offset_start,
+                             size_t offset_end) {
+    const int fd = fileno(fp);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        return false;
+
+    /* The offsets are relative to the current file position */
+    const off_t file_pos = lseek(fd, 0, SEEK_CUR);
+    if (file_pos < 0)
+        return false;
+
+    const size_t file_size = st.st_size;
+    size_t real_start      = file_pos + offset_start;
+    size_t real_end =
+      (offset_end == 0) ? file_size : (size_t)file_pos + offset_end;
+    if (real_end > file_size)
+        real_end = file_size;
+
+    /* Nothing to map, return an empty array like the copying path would */
+    if (real_start >= real_end) {
+        dst->data         = NULL;
+        dst->size         = 0;
+        dst->mapping      = NULL;
+        dst->mapping_size = 0;
+        return true;
+    }
+
+    return byte_array_map(dst, fd, real_start, real_end - real_start);
+}
+
+bool file_make_dir(const char* path) {
+    if (mkdir(path, 0755) == 0)
+        return true;
+
+    /* An existing directory is not an error */
+    struct stat st;
+    return errno == EEXIST && stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool file_skip(FILE* fp, size_t bytes) {
+    if (bytes == 0)
+        return true;
+
+    if (fseeko(fp, (off_t)bytes, SEEK_CUR) == 0)
+        return true;
+
+    static uint8_t discarded[SKIP_BUFFER_SIZE];
+    while (bytes > 0) {
+        const size_t to_read =
+          (bytes < sizeof(discarded)) ? bytes : sizeof(discarded);
+        const size_t bytes_read = fread(discarded, 1, to_read, fp);
+        if (bytes_read == 0)
+            return !ferror(fp);
+        bytes -= bytes_read;
+    }
+
+    return true;
+}
+
+/*
+ * Get the number of bytes left in a file, from the current position. Returns
+ * zero if it can't be determined (e.g. because it's a pipe).
+ */
+static size_t file_remaining_size(FILE* fp) {
+    const int fd = fileno(fp);
+    if (fd < 0)
+        return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        return 0;
+
+    const off_t file_pos = ftello(fp);
+    if (file_pos < 0 || file_pos >= st.st_size)
+        return 0;
+
+    return st.st_size - file_pos;
+}
+
+/*
+ * Free all the nodes of a 'FileChunk' list, along with their data.
+ */
+static void free_chunks(FileChunk* chunk) {
+    while (chunk != NULL) {
+        FileChunk* next = chunk->next;
+        free(chunk->data);
+        free(chunk);
+        chunk = next;
+    }
+}
+
+/*
+ * Read up to 'max_size' bytes from the current position of the file into the
+ * 'dst' array, until the end of the file is reached. The data is read in large
+ * chunks into a linked list, and only concatenated once at the end if more than
+ * one chunk was needed. If the file is redirected from a regular file, the
+ * first chunk is allocated with its exact remaining size.
+ */
+static bool file_read_stream(ByteArray* dst, FILE* fp, size_t max_size) {
+    FileChunk* first_chunk = NULL;
+    FileChunk* last_chunk  = NULL;
+    size_t total_size      = 0;
+
+    size_t chunk_size = file_remaining_size(fp);
+    if (chunk_size == 0)
+        chunk_size = MIN_CHUNK_SIZE;
+
+    while (total_size < max_size) {
+        if (chunk_size > max_size - total_size)
+            chunk_size = max_size - total_size;
+
+        FileChunk* chunk = malloc(sizeof(FileChunk));
+        if (chunk == NULL) {
+            free_chunks(first_chunk);
+            return false;
+        }
+        chunk->data = malloc(chunk_size);
+        chunk->next = NULL;
+        if (chunk->data == NULL) {
+            free(chunk);
+            free_chunks(first_chunk);
+            return false;
+        }
+
+        chunk->size = fread(chunk->data, 1, chunk_size, fp);
+        if (chunk->size == 0) {
+            free(chunk->data);
+            free(chunk);
+            break;
+        }
+
+        if (last_chunk == NULL)
+            first_chunk = chunk;
+        else
+            last_chunk->next = chunk;
+        last_chunk = chunk;
+        total_size += chunk->size;
+
+        /* A partial read means that we reached the end of the file */
+        if (chunk->size < chunk_size)
+            break;
+
+        /*
+         * The first chunk usually has the exact size of a regular file, so
+         * check if there is more data before allocating a bigger chunk.
+         */
+        const int next_byte = fgetc(fp);
+        if (next_byte == EOF)
+            break;
+        ungetc(next_byte, fp);
+
+        if (chunk_size < MAX_CHUNK_SIZE)
+            chunk_size *= 2;
+        if (chunk_size < MIN_CHUNK_SIZE)
+            chunk_size = MIN_CHUNK_SIZE;
+    }
+
+    if (ferror(fp)) {
+        free_chunks(first_chunk);
+        return false;
+    }
+
+    dst->mapping      = NULL;
+    dst->mapping_size = 0;
+    dst->size         = total_size;
+
+    if (first_chunk == NULL) {
+        dst->data = NULL;
+        return true;
+    }
+
+    /*
+     * If a single chunk was needed, just give its buffer to the caller,
+     * releasing the unused part.
+     */
+    if (first_chunk->next == NULL) {
+        dst->data    = first_chunk->data;
+        void* shrunk = realloc(dst->data, first_chunk->size);
+        if (shrunk != NULL)
+            dst->data = shrunk;
+        free(first_chunk);
+        return true;
+    }
+
+    dst->data = malloc(total_size);
+    if (dst->data == NULL) {
+        free_chunks(first_chunk);
+        return false;
+    }
+
+    size_t dst_pos = 0;
+    for (FileChunk* chunk = first_chunk; chunk != NULL; chunk = chunk->next) {
+        memcpy(&dst->data[dst_pos], chunk->data, chunk->size);
+        dst_pos += chunk->size;
+    }
+    assert(dst_pos == total_size);
+
+    free_chunks(first_chunk);
+    return true;
+}
+
+bool file_region_size(FILE* fp,
+                      size_t offset_start,
+                      size_t offset_end,
+                      size_t* out) {
+    const int fd = fileno(fp);
+    if (fd < 0)
+        return false;
+
+    /*
+     * Only regular files have a reliable size. Note that an empty file might
+     * also be a special file (e.g. in '/proc').
+     */
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+        return false;
+
+    const off_t file_pos = ftello(fp);
+    if (file_pos < 0)
+        return false;
+
+    const size_t file_size  = st.st_size;
+    const size_t real_start = file_pos + offset_start;
+    size_t real_end =
+      (offset_end == 0) ? file_size : (size_t)file_pos + offset_end;
+    if (real_end > file_size)
+        real_end = file_size;
+
+    *out = (real_start < real_end) ? real_end - real_start : 0;
+    return true;
+}
+
 bool file_read(ByteArray* dst,
                FILE* fp,
                size_t offset_start,
@@ -56,34 +330,84 @@ bool file_read(ByteArray* dst,
     const bool has_offset_end = (offset_end != 0);
     assert(!has_offset_end || offset_end >= offset_start);
 
-    /* Allocate and initialize the 'ByteArray' structure */
-    const size_t initial_size =
-      (offset_end == 0) ? 255 : offset_end - offset_start;
-    byte_array_init(dst, initial_size);
+    /*
+     * Regular files are mapped into memory, avoiding the copy. Pipes and
+     * other special files need to be copied below.
+     */
+    if (file_read_mapped(dst, fp, offset_start, offset_end))
+        return true;
 
     /* Skip initial bytes */
-    size_t file_pos;
-    int last_char = 0;
-    for (file_pos = 0; file_pos < offset_start && last_char != EOF; file_pos++)
-        last_char = fgetc(fp);
-
-    /* Read the target bytes from the file, resizing it dynamically */
-    size_t dst_pos;
-    for (dst_pos = 0; (!has_offset_end || file_pos < offset_end);
-         dst_pos++, file_pos++) {
-        if (dst_pos >= dst->size && !byte_array_resize(dst, dst->size * 2))
-            return false;
+    if (!file_skip(fp, offset_start))
+        return false;
 
-        last_char = fgetc(fp);
-        if (last_char == EOF)
-            break;
+    /* Read the target bytes from the file in large blocks */
+    const size_t max_size =
+      has_offset_end ? offset_end - offset_start : SIZE_MAX;
+    return file_read_stream(dst, fp, max_size);
+}
+
+bool file_read_regions(ByteArray* dsts,
+                       FILE* fp,
+                       const ArgsRegion* regions,
+                       size_t regions_num) {
+    assert(regions_num > 0);
 
-        dst->data[dst_pos] = last_char;
+    /*
+     * If the file is seekable, read each region independently, always starting
+     * from the original position, since the offsets are relative to it.
+     * Regular files are mapped, so this doesn't actually copy any data.
+     */
+    const off_t initial_pos = ftello(fp);
+    if (initial_pos >= 0) {
+        for (size_t i = 0; i < regions_num; i++) {
+            if (fseeko(fp, initial_pos, SEEK_SET) != 0 ||
+                !file_read(&dsts[i], fp, regions[i].start, regions[i].end)) {
+                while (i-- > 0)
+                    byte_array_destroy(&dsts[i]);
+                return false;
+            }
+        }
+        return true;
     }
 
-    /* Overwrite with the actual length */
-    assert(dst_pos <= dst->size);
-    dst->size = dst_pos;
+    /*
+     * Otherwise, the file can only be read once. Read from the lowest start
+     * offset to the highest end offset, and copy each region from there.
+     */
+    size_t lowest_start = regions[0].start;
+    size_t highest_end  = regions[0].end;
+    for (size_t i = 1; i < regions_num; i++) {
+        if (regions[i].start < lowest_start)
+            lowest_start = regions[i].start;
+        if (highest_end != 0 &&
+            (regions[i].end == 0 || regions[i].end > highest_end))
+            highest_end = regions[i].end;
+    }
+
+    ByteArray all_bytes;
+    if (!file_read(&all_bytes, fp, lowest_start, highest_end))
+        return false;
+
+    for (size_t i = 0; i < regions_num; i++) {
+        /* Limit the region to the bytes that were actually read */
+        const size_t start = regions[i].start - lowest_start;
+        size_t end = (regions[i].end == 0) ? all_bytes.size
+                                           : regions[i].end - lowest_start;
+        if (end > all_bytes.size)
+            end = all_bytes.size;
+        const size_t size = (start < end) ? end - start : 0;
+
+        if (!byte_array_init(&dsts[i], size)) {
+            while (i-- > 0)
+                byte_array_destroy(&dsts[i]);
+            byte_array_destroy(&all_bytes);
+            return false;
+        }
+        if (size > 0)
+            memcpy(dsts[i].data, &all_bytes.data[start], size);
+    }
 
+    byte_array_destroy(&all_bytes);
     return true;
 }
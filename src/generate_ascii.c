@@ -16,15 +16,30 @@
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 
 #include "include/generate.h"
 #include "include/image.h"
 #include "include/args.h"
 #include "include/byte_array.h"
+#include "include/parallel.h"
 #include "include/util.h"
 
+/* Colors of the printable ASCII characters, and of the unknown bytes */
+static const Color g_color_printable = { 0x37, 0x7E, 0xB8 };
+static const Color g_color_unknown   = { 0xE4, 0x1A, 0x1C };
+
+/* Index of each color in the palette of the image */
+enum EColorIndex {
+    COLOR_IDX_BLACK,
+    COLOR_IDX_WHITE,
+    COLOR_IDX_PRINTABLE,
+    COLOR_IDX_UNKNOWN,
+};
+
 static bool validate_args(const Args* args) {
     if (args->block_size != ARGS_DEFAULT_BLOCK_SIZE)
         WRN("The current mode (%s) is not affected by the user-specified block "
@@ -34,17 +49,22 @@ static bool validate_args(const Args* args) {
     return true;
 }
 
-static inline Image* alloc_and_init_image(const Args* args, ByteArray* bytes) {
+static inline Image* alloc_and_init_image(const Args* args,
+                                         ByteArray* bytes,
+                                         size_t samples_per_pixel) {
     Image* image = malloc(sizeof(Image));
     if (image == NULL)
         return NULL;
 
+    const size_t num_pixels =
+      (bytes->size + samples_per_pixel - 1) / samples_per_pixel;
+
     size_t width  = args->output_width;
-    size_t height = bytes->size / width;
-    if (bytes->size % width != 0)
+    size_t height = num_pixels / width;
+    if (num_pixels % width != 0)
         height++;
 
-    if (!image_init(image, width, height))
+    if (!generate_ascii_image_init(image, width, height))
         return NULL;
 
     return image;
@@ -52,51 +72,122 @@ static inline Image* alloc_and_init_image(const Args* args, ByteArray* bytes) {
 
 /*----------------------------------------------------------------------------*/
 
+/*
+ * Get the palette index of the pixel depending on the byte value.
+ */
+static inline enum EColorIndex byte_color_index(uint8_t byte) {
+    if (byte == 0x00) {
+        /* Common padding values, either black or white */
+        return COLOR_IDX_BLACK;
+    } else if (byte == 0xFF) {
+        return COLOR_IDX_WHITE;
+    } else if (isgraph(byte) || isspace(byte)) {
+        /* Printable ASCII, blue */
+        return COLOR_IDX_PRINTABLE;
+    } else {
+        /* Unknown, red */
+        return COLOR_IDX_UNKNOWN;
+    }
+}
+
+/*
+ * Data shared by all the threads of 'generate_ascii_rows'.
+ */
+typedef struct {
+    const ByteArray* bytes;
+    size_t samples_per_pixel;
+    Image* image;
+} AsciiJobData;
+
+/*
+ * Render the pixels in the [start..end) range, each with the most common color
+ * of its samples. Ties are resolved in favor of the last color in the
+ * 'EColorIndex' enumerator, since they are less common in most files.
+ */
+static void ascii_job(void* data, size_t job, size_t start, size_t end) {
+    UNUSED(job);
+    const AsciiJobData* ctx = data;
+    const ByteArray* bytes  = ctx->bytes;
+    const size_t samples    = ctx->samples_per_pixel;
+
+    for (size_t i = start; i < end; i++) {
+        if (samples <= 1) {
+            ctx->image->data[i] = byte_color_index(bytes->data[i]);
+            continue;
+        }
+
+        const size_t first = i * samples;
+        const size_t last =
+          (first + samples < bytes->size) ? first + samples : bytes->size;
+
+        size_t occurrences[COLOR_IDX_UNKNOWN + 1] = { 0 };
+        for (size_t j = first; j < last; j++)
+            occurrences[byte_color_index(bytes->data[j])]++;
+
+        uint8_t most_common = COLOR_IDX_BLACK;
+        for (uint8_t idx = COLOR_IDX_BLACK; idx <= COLOR_IDX_UNKNOWN; idx++)
+            if (occurrences[idx] >= occurrences[most_common])
+                most_common = idx;
+
+        ctx->image->data[i] = most_common;
+    }
+}
+
+bool generate_ascii_rows(const Args* args,
+                         const ByteArray* bytes,
+                         size_t samples_per_pixel,
+                         Image* image) {
+    const size_t num_pixels = image->width * image->height;
+
+    size_t used_pixels =
+      (bytes->size + samples_per_pixel - 1) / samples_per_pixel;
+    if (used_pixels > num_pixels)
+        used_pixels = num_pixels;
+
+    AsciiJobData data = {
+        .bytes             = bytes,
+        .samples_per_pixel = samples_per_pixel,
+        .image             = image,
+    };
+    parallel_for(args->jobs, used_pixels, ascii_job, &data);
+
+    /*
+     * If we are not in-bounds, we are filling the last row; use a generic
+     * padding color.
+     */
+    memset(&image->data[used_pixels],
+           COLOR_IDX_BLACK,
+           num_pixels - used_pixels);
+
+    return true;
+}
+
+bool generate_ascii_image_init(Image* image, size_t width, size_t height) {
+    static const Color black = { 0x00, 0x00, 0x00 };
+    static const Color white = { 0xFF, 0xFF, 0xFF };
+
+    if (!image_init(image, IMAGE_FORMAT_INDEXED8, width, height))
+        return false;
+
+    /* Must match the order of 'EColorIndex' */
+    image_palette_add(&image->palette, black);
+    image_palette_add(&image->palette, white);
+    image_palette_add(&image->palette, g_color_printable);
+    image_palette_add(&image->palette, g_color_unknown);
+    return true;
+}
+
 Image* generate_ascii(const Args* args, ByteArray* bytes) {
     if (!validate_args(args))
         return NULL;
 
-    Image* image = alloc_and_init_image(args, bytes);
+    const size_t samples_per_pixel =
+      generate_samples_per_pixel(args, bytes->size);
+
+    Image* image = alloc_and_init_image(args, bytes, samples_per_pixel);
     if (image == NULL)
         return NULL;
 
-    for (size_t y = 0; y < image->height; y++) {
-        for (size_t x = 0; x < image->width; x++) {
-            const size_t raw_idx = (size_t)image->width * y + x;
-            Color* color         = &image->pixels[raw_idx];
-
-            /*
-             * If we are not in-bounds, we are filling the last row; use a
-             * generic padding color.
-             */
-            if (raw_idx >= bytes->size) {
-                color->r = color->g = color->b = 0x00;
-                continue;
-            }
-
-            /*
-             * Determine the RGB color of the pixel depending on the byte
-             * value.
-             */
-            const uint8_t byte = bytes->data[raw_idx];
-            if (byte == 0x00 || byte == 0xFF) {
-                /* Common padding values, either black or white */
-                color->r = byte;
-                color->g = byte;
-                color->b = byte;
-            } else if (isgraph(byte) || isspace(byte)) {
-                /* Printable ASCII, blue */
-                color->r = 0x37;
-                color->g = 0x7E;
-                color->b = 0xB8;
-            } else {
-                /* Unknown, red */
-                color->r = 0xE4;
-                color->g = 0x1A;
-                color->b = 0x1C;
-            }
-        }
-    }
-
+    generate_ascii_rows(args, bytes, samples_per_pixel, image);
     return image;
 }
@@ -24,6 +24,7 @@
 #include "include/image.h"
 #include "include/args.h"
 #include "include/byte_array.h"
+#include "include/parallel.h"
 #include "include/util.h"
 
 static bool validate_args(const Args* args) {
@@ -47,12 +48,47 @@ static inline Image* alloc_and_init_image(void) {
 
     const size_t width  = UCHAR_MAX + 1;
     const size_t height = UCHAR_MAX + 1;
-    if (!image_init(image, width, height))
+    if (!image_init(image, IMAGE_FORMAT_GRAY8, width, height))
         return NULL;
 
     return image;
 }
 
+/*
+ * Number of possible bigrams, and therefore, number of pixels in the image.
+ */
+#define NUM_BIGRAMS ((UCHAR_MAX + 1) * (UCHAR_MAX + 1))
+
+/*
+ * Data shared by all the threads of 'generate_bigrams'.
+ */
+typedef struct {
+    const ByteArray* bytes;
+
+    /* Array of 'NUM_BIGRAMS' counters for each job */
+    size_t* occurrences;
+} BigramsJobData;
+
+/*
+ * Count the occurrences of the bigrams that end in the [start..end) range of
+ * the input, excluding the first sample, into the counters of the current job.
+ */
+static void bigrams_job(void* data, size_t job, size_t start, size_t end) {
+    const BigramsJobData* ctx = data;
+    const uint8_t* input      = ctx->bytes->data;
+    size_t* occurrences       = &ctx->occurrences[NUM_BIGRAMS * job];
+
+    if (start == 0)
+        start = 1;
+
+    /*
+     * The index is determined by the values of the current byte (Y) and the
+     * previous one (X).
+     */
+    for (size_t i = start; i < end; i++)
+        occurrences[(input[i] << CHAR_BIT) | input[i - 1]]++;
+}
+
 /*----------------------------------------------------------------------------*/
 
 Image* generate_bigrams(const Args* args, ByteArray* bytes) {
@@ -64,35 +100,42 @@ Image* generate_bigrams(const Args* args, ByteArray* bytes) {
         return NULL;
     assert(image->width == UCHAR_MAX + 1 && image->height == UCHAR_MAX + 1);
 
-    /* Initialize the image to black */
-    for (size_t y = 0; y < image->height; y++) {
-        for (size_t x = 0; x < image->width; x++) {
-            Color* color = &image->pixels[image->width * y + x];
-            color->r = color->g = color->b = 0x00;
-        }
+    /*
+     * Count the occurrences of each bigram on multiple threads, each with its
+     * own counters, and merge them.
+     */
+    const size_t jobs = parallel_get_jobs(args->jobs, bytes->size);
+    BigramsJobData data = {
+        .bytes       = bytes,
+        .occurrences = calloc(jobs * NUM_BIGRAMS, sizeof(size_t)),
+    };
+    if (data.occurrences == NULL) {
+        image_deinit(image);
+        free(image);
+        return NULL;
     }
+    parallel_for(jobs, bytes->size, bigrams_job, &data);
+
+    size_t* occurrences = data.occurrences;
+    for (size_t job = 1; job < jobs; job++)
+        for (size_t i = 0; i < NUM_BIGRAMS; i++)
+            occurrences[i] += data.occurrences[NUM_BIGRAMS * job + i];
+
+    size_t max_occurrences = 0;
+    for (size_t i = 0; i < NUM_BIGRAMS; i++)
+        if (occurrences[i] > max_occurrences)
+            max_occurrences = occurrences[i];
 
     /*
-     * In this case we don't want to iterate the image, but the bytes-> We start
-     * from the second byte because we are plotting bigrams (pairs).
+     * Draw each bigram based on its occurrences relative to the most frequent
+     * one, using the scale specified by the user.
      */
-    for (size_t i = 1; i < bytes->size; i++) {
-        const uint8_t x = bytes->data[i - 1];
-        const uint8_t y = bytes->data[i];
-
-        /*
-         * The position is determined by the values of the current byte and the
-         * previous one.
-         */
-        Color* color = &image->pixels[image->width * y + x];
-
-        /*
-         * This mode just plots whether a bigram is present or not in the input.
-         * We don't change the colors depending on the occurrences or anything
-         * like that.
-         */
-        color->r = color->g = color->b = 0xFF;
+    for (size_t i = 0; i < NUM_BIGRAMS; i++) {
+        image->data[i] = generate_scaled_intensity(args->scale,
+                                                   occurrences[i],
+                                                   max_occurrences);
     }
 
+    free(occurrences);
     return image;
 }
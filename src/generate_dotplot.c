@@ -46,7 +46,7 @@ static inline Image* alloc_and_init_image(ByteArray* bytes) {
 
     const size_t width  = bytes->size;
     const size_t height = bytes->size;
-    if (!image_init(image, width, height))
+    if (!image_init(image, IMAGE_FORMAT_GRAY8, width, height))
         return NULL;
 
     return image;
@@ -65,8 +65,6 @@ Image* generate_dotplot(const Args* args, ByteArray* bytes) {
 
     for (size_t y = 0; y < image->height; y++) {
         for (size_t x = 0; x < image->width; x++) {
-            Color* color = &image->pixels[image->width * y + x];
-
             /*
              * The dotplot is used to meassure self-similarity. For each point
              * (X,Y), set the point if the X-th sample matches the Y-th sample.
@@ -83,7 +81,7 @@ Image* generate_dotplot(const Args* args, ByteArray* bytes) {
              *   D|     *
              */
             assert(x < bytes->size && y < bytes->size);
-            color->r = color->g = color->b =
+            image->data[image->width * y + x] =
               (bytes->data[x] == bytes->data[y]) ? 0xFF : 0x00;
         }
     }
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "include/generate.h"
+#include "include/image.h"
+#include "include/args.h"
+#include "include/byte_array.h"
+#include "include/entropy.h"
+#include "include/parallel.h"
+#include "include/util.h"
+
+/*
+ * Data shared by all the threads of 'generate_dotplot_density'.
+ */
+typedef struct {
+    const ByteArray* bytes;
+
+    /* Number of tiles in each axis, and the side of the output image */
+    size_t side;
+
+    /* Array of 'ENTROPY_BINS' counters for each tile */
+    size_t* occurrences;
+
+    /* Match density of each output cell, in row-major order */
+    double* density;
+
+    /* Maximum density found by each job */
+    double* max_density;
+} DotplotDensityJobData;
+
+/*----------------------------------------------------------------------------*/
+
+static bool validate_args(const Args* args) {
+    if (args->block_size != ARGS_DEFAULT_BLOCK_SIZE)
+        WRN("The current mode (%s) is not affected by the user-specified block "
+            "size (%zu).",
+            args_get_mode_name(args->mode),
+            args->block_size);
+    return true;
+}
+
+static inline Image* alloc_and_init_image(const Args* args, ByteArray* bytes) {
+    Image* image = malloc(sizeof(Image));
+    if (image == NULL)
+        return NULL;
+
+    /* Each pixel represents at least one sample in each axis */
+    size_t side = args->output_width;
+    if (side > bytes->size)
+        side = bytes->size;
+
+    if (!image_init(image, IMAGE_FORMAT_GRAY8, side, side))
+        return NULL;
+
+    return image;
+}
+
+/*
+ * Get the offset of the first sample of the specified tile. The input is split
+ * as evenly as possible, so tiles differ in at most one sample.
+ */
+static inline size_t tile_start(const DotplotDensityJobData* ctx, size_t tile) {
+    return tile * ctx->bytes->size / ctx->side;
+}
+
+/*
+ * Count the occurrences of each byte in the tiles of the [start..end) range.
+ */
+static void histogram_job(void* data, size_t job, size_t start, size_t end) {
+    UNUSED(job);
+    const DotplotDensityJobData* ctx = data;
+
+    for (size_t tile = start; tile < end; tile++) {
+        const size_t first = tile_start(ctx, tile);
+        const size_t last  = tile_start(ctx, tile + 1);
+        entropy_count_bytes(&ctx->bytes->data[first],
+                            last - first,
+                            &ctx->occurrences[ENTROPY_BINS * tile]);
+    }
+}
+
+/*
+ * Calculate the density of the rows in the [start..end) range.
+ *
+ * The number of matching pairs of samples between two tiles is the sum, for
+ * each byte, of its occurrences in the first tile multiplied by its occurrences
+ * in the second one. This is exactly the number of points that the regular
+ * dotplot would set in the area covered by the cell, without having to compare
+ * each pair of samples.
+ */
+static void density_job(void* data, size_t job, size_t start, size_t end) {
+    const DotplotDensityJobData* ctx = data;
+
+    double max_density = 0.0;
+    for (size_t y = start; y < end; y++) {
+        const size_t* row_occurrences = &ctx->occurrences[ENTROPY_BINS * y];
+        const size_t row_size = tile_start(ctx, y + 1) - tile_start(ctx, y);
+
+        for (size_t x = 0; x < ctx->side; x++) {
+            const size_t* col_occurrences = &ctx->occurrences[ENTROPY_BINS * x];
+            const size_t col_size = tile_start(ctx, x + 1) - tile_start(ctx, x);
+
+            uint64_t matches = 0;
+            for (int byte = 0; byte < ENTROPY_BINS; byte++)
+                matches +=
+                  (uint64_t)row_occurrences[byte] * col_occurrences[byte];
+
+            const double density =
+              (double)matches / ((double)row_size * col_size);
+            ctx->density[ctx->side * y + x] = density;
+            if (density > max_density)
+                max_density = density;
+        }
+    }
+
+    ctx->max_density[job] = max_density;
+}
+
+/*----------------------------------------------------------------------------*/
+
+Image* generate_dotplot_density(const Args* args, ByteArray* bytes) {
+    if (!validate_args(args))
+        return NULL;
+
+    Image* image = alloc_and_init_image(args, bytes);
+    if (image == NULL)
+        return NULL;
+    assert(image->width == image->height && image->width <= bytes->size);
+
+    const size_t side = image->width;
+    const size_t jobs = parallel_get_jobs(args->jobs, side);
+    DotplotDensityJobData data = {
+        .bytes       = bytes,
+        .side        = side,
+        .occurrences = calloc(side * ENTROPY_BINS, sizeof(size_t)),
+        .density     = malloc(side * side * sizeof(double)),
+        .max_density = calloc(jobs, sizeof(double)),
+    };
+    if (data.occurrences == NULL || data.density == NULL ||
+        data.max_density == NULL) {
+        free(data.occurrences);
+        free(data.density);
+        free(data.max_density);
+        image_deinit(image);
+        free(image);
+        return NULL;
+    }
+
+    parallel_for(jobs, side, histogram_job, &data);
+    parallel_for(jobs, side, density_job, &data);
+
+    double max_density = 0.0;
+    for (size_t job = 0; job < jobs; job++)
+        if (data.max_density[job] > max_density)
+            max_density = data.max_density[job];
+
+    /*
+     * Draw each cell based on its density relative to the most dense cell,
+     * which will usually be in the diagonal, using the scale specified by the
+     * user. Since the logarithmic scale expects counters, the densities are
+     * converted back to the number of matches in an average tile.
+     */
+    const double tile_size = (double)bytes->size / side;
+    const double tile_area = tile_size * tile_size;
+    for (size_t i = 0; i < side * side; i++) {
+        image->data[i] = generate_scaled_intensity(args->scale,
+                                                   data.density[i] * tile_area,
+                                                   max_density * tile_area);
+    }
+
+    free(data.occurrences);
+    free(data.density);
+    free(data.max_density);
+    return image;
+}
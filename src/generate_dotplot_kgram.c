@@ -0,0 +1,286 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/generate.h"
+#include "include/image.h"
+#include "include/args.h"
+#include "include/byte_array.h"
+#include "include/parallel.h"
+#include "include/util.h"
+
+/*
+ * Base of the polynomial rolling hash. Since the k-grams with the same hash are
+ * compared afterwards, collisions only affect performance.
+ */
+#define HASH_BASE 0x100000001B3ULL
+
+/*
+ * Position of a k-gram in the input, along with its hash.
+ */
+typedef struct {
+    uint64_t hash;
+    size_t pos;
+} KgramEntry;
+
+/*
+ * Data shared by all the threads of 'generate_dotplot_kgram'.
+ */
+typedef struct {
+    const ByteArray* bytes;
+    size_t kgram_size;
+
+    /* Value of 'HASH_BASE' raised to 'kgram_size - 1' */
+    uint64_t base_pow;
+
+    /* Entry for each k-gram in the input */
+    KgramEntry* entries;
+} KgramHashJobData;
+
+/*----------------------------------------------------------------------------*/
+
+static bool validate_args(const Args* args, const ByteArray* bytes) {
+    if (args->block_size != ARGS_DEFAULT_BLOCK_SIZE)
+        WRN("The current mode (%s) is not affected by the user-specified block "
+            "size (%zu).",
+            args_get_mode_name(args->mode),
+            args->block_size);
+    if (args->kgram_size > bytes->size) {
+        ERR("The k-gram size (%zu) is bigger than the input (%zu bytes).",
+            args->kgram_size,
+            bytes->size);
+        return false;
+    }
+    return true;
+}
+
+static inline Image* alloc_and_init_image(const Args* args,
+                                          size_t num_kgrams) {
+    Image* image = malloc(sizeof(Image));
+    if (image == NULL)
+        return NULL;
+
+    /* Each pixel represents at least one k-gram in each axis */
+    size_t side = args->output_width;
+    if (side > num_kgrams)
+        side = num_kgrams;
+
+    if (!image_init(image, IMAGE_FORMAT_GRAY8, side, side))
+        return NULL;
+
+    return image;
+}
+
+/*
+ * Calculate the hash of the k-grams in the [start..end) range. The hash of the
+ * first one is calculated from scratch, and the rest are obtained by removing
+ * the first byte of the previous k-gram and adding the next one.
+ */
+static void hash_job(void* data, size_t job, size_t start, size_t end) {
+    UNUSED(job);
+    const KgramHashJobData* ctx = data;
+    const uint8_t* input        = ctx->bytes->data;
+
+    uint64_t hash = 0;
+    for (size_t i = 0; i < ctx->kgram_size; i++)
+        hash = hash * HASH_BASE + input[start + i];
+
+    for (size_t pos = start; pos < end; pos++) {
+        if (pos > start)
+            hash = (hash - input[pos - 1] * ctx->base_pow) * HASH_BASE +
+                   input[pos + ctx->kgram_size - 1];
+
+        ctx->entries[pos].hash = hash;
+        ctx->entries[pos].pos  = pos;
+    }
+}
+
+/*
+ * Sort the entries by hash with a LSD radix sort, one byte of the hash per
+ * pass. The 'tmp' array must be able to hold the same number of entries, and
+ * the returned pointer is the array that ended up containing the sorted
+ * entries, either 'entries' or 'tmp'.
+ */
+static KgramEntry* sort_entries(KgramEntry* entries,
+                                KgramEntry* tmp,
+                                size_t num) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t offsets[UCHAR_MAX + 1] = { 0 };
+        for (size_t i = 0; i < num; i++)
+            offsets[(entries[i].hash >> shift) & UCHAR_MAX]++;
+
+        /* All entries have the same byte in this position, nothing to do */
+        if (offsets[(entries[0].hash >> shift) & UCHAR_MAX] == num)
+            continue;
+
+        size_t total = 0;
+        for (int byte = 0; byte <= UCHAR_MAX; byte++) {
+            const size_t count = offsets[byte];
+            offsets[byte]      = total;
+            total += count;
+        }
+
+        for (size_t i = 0; i < num; i++)
+            tmp[offsets[(entries[i].hash >> shift) & UCHAR_MAX]++] = entries[i];
+
+        KgramEntry* swap = entries;
+        entries          = tmp;
+        tmp              = swap;
+    }
+
+    return entries;
+}
+
+static inline bool kgrams_match(const ByteArray* bytes,
+                                size_t kgram_size,
+                                const KgramEntry* a,
+                                const KgramEntry* b) {
+    return memcmp(&bytes->data[a->pos], &bytes->data[b->pos], kgram_size) == 0;
+}
+
+/*
+ * Draw the points for the k-grams in the specified array, which must have the
+ * same hash. Since different k-grams might have the same hash, they are split
+ * into groups of matching k-grams, and each pair of tiles containing k-grams of
+ * the same group is drawn. Each tile is only drawn once per group, regardless
+ * of the number of matches.
+ *
+ * The 'tile_group' array contains the last group that used each tile, and
+ * 'group' is incremented for each group. The 'tiles' array must be able to
+ * hold as many tiles as the image width.
+ */
+static void draw_matches(const ByteArray* bytes,
+                         size_t kgram_size,
+                         KgramEntry* entries,
+                         size_t num,
+                         Image* image,
+                         size_t num_kgrams,
+                         size_t* tiles,
+                         size_t* tile_group,
+                         size_t* group) {
+    const size_t side = image->width;
+
+    while (num > 0) {
+        (*group)++;
+
+        /*
+         * Store the tiles of the k-grams that match the first one, and move the
+         * rest to the start of the array for the next iteration.
+         */
+        const KgramEntry first = entries[0];
+        size_t tiles_num       = 0;
+        size_t remaining       = 0;
+        for (size_t i = 0; i < num; i++) {
+            if (i > 0 && !kgrams_match(bytes, kgram_size, &first, &entries[i])) {
+                entries[remaining++] = entries[i];
+                continue;
+            }
+
+            const size_t tile = entries[i].pos * side / num_kgrams;
+            if (tile_group[tile] != *group) {
+                tile_group[tile]   = *group;
+                tiles[tiles_num++] = tile;
+            }
+        }
+
+        for (size_t y = 0; y < tiles_num; y++) {
+            for (size_t x = 0; x < tiles_num; x++)
+                image->data[side * tiles[y] + tiles[x]] = 0xFF;
+        }
+
+        num = remaining;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+Image* generate_dotplot_kgram(const Args* args, ByteArray* bytes) {
+    if (!validate_args(args, bytes))
+        return NULL;
+
+    const size_t num_kgrams = bytes->size - args->kgram_size + 1;
+    Image* image            = alloc_and_init_image(args, num_kgrams);
+    if (image == NULL)
+        return NULL;
+    assert(image->width == image->height && image->width <= num_kgrams);
+
+    const size_t side   = image->width;
+    KgramEntry* entries = malloc(num_kgrams * sizeof(KgramEntry));
+    KgramEntry* tmp     = malloc(num_kgrams * sizeof(KgramEntry));
+    size_t* tiles       = malloc(side * sizeof(size_t));
+    size_t* tile_group  = calloc(side, sizeof(size_t));
+    if (entries == NULL || tmp == NULL || tiles == NULL || tile_group == NULL) {
+        free(entries);
+        free(tmp);
+        free(tiles);
+        free(tile_group);
+        image_deinit(image);
+        free(image);
+        return NULL;
+    }
+
+    uint64_t base_pow = 1;
+    for (size_t i = 1; i < args->kgram_size; i++)
+        base_pow *= HASH_BASE;
+
+    KgramHashJobData data = {
+        .bytes      = bytes,
+        .kgram_size = args->kgram_size,
+        .base_pow   = base_pow,
+        .entries    = entries,
+    };
+    parallel_for(args->jobs, num_kgrams, hash_job, &data);
+
+    /*
+     * Sort the k-grams by hash, so the k-grams that might match are
+     * consecutive, and draw each run of k-grams with the same hash.
+     */
+    KgramEntry* sorted = sort_entries(entries, tmp, num_kgrams);
+
+    size_t group     = 0;
+    size_t run_start = 0;
+    while (run_start < num_kgrams) {
+        size_t run_end = run_start + 1;
+        while (run_end < num_kgrams &&
+               sorted[run_end].hash == sorted[run_start].hash)
+            run_end++;
+
+        draw_matches(bytes,
+                     args->kgram_size,
+                     &sorted[run_start],
+                     run_end - run_start,
+                     image,
+                     num_kgrams,
+                     tiles,
+                     tile_group,
+                     &group);
+
+        run_start = run_end;
+    }
+
+    free(tile_group);
+    free(tiles);
+    free(tmp);
+    free(entries);
+    return image;
+}
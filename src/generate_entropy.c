@@ -19,6 +19,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
 #include <math.h> /* pow() */
 
@@ -26,6 +27,8 @@
 #include "include/image.h"
 #include "include/args.h"
 #include "include/byte_array.h"
+#include "include/entropy.h"
+#include "include/parallel.h"
 #include "include/util.h"
 
 static bool validate_args(const Args* args) {
@@ -39,17 +42,22 @@ static bool validate_args(const Args* args) {
     return true;
 }
 
-static inline Image* alloc_and_init_image(const Args* args, ByteArray* bytes) {
+static inline Image* alloc_and_init_image(const Args* args,
+                                         ByteArray* bytes,
+                                         size_t samples_per_pixel) {
     Image* image = malloc(sizeof(Image));
     if (image == NULL)
         return NULL;
 
+    const size_t num_pixels =
+      (bytes->size + samples_per_pixel - 1) / samples_per_pixel;
+
     size_t width  = args->output_width;
-    size_t height = bytes->size / width;
-    if (bytes->size % width != 0)
+    size_t height = num_pixels / width;
+    if (num_pixels % width != 0)
         height++;
 
-    if (!image_init(image, width, height))
+    if (!generate_entropy_image_init(image, width, height))
         return NULL;
 
     return image;
@@ -57,50 +65,198 @@ static inline Image* alloc_and_init_image(const Args* args, ByteArray* bytes) {
 
 /*----------------------------------------------------------------------------*/
 
-Image* generate_entropy(const Args* args, ByteArray* bytes) {
-    if (!validate_args(args))
-        return NULL;
+/*
+ * Get the color used for representing the specified intensity, in the [00..FF]
+ * range, in the entropy-based modes.
+ */
+static Color intensity_color(uint8_t intensity) {
+    Color color;
+#ifdef BIN_GRAPH_HEATMAP
+    /*
+     * The heatmap visualization uses a linear scale for blue values, but an
+     * exponential scale for red values. This representation is more closely
+     * related to how entropy is calculated (using a base 2 logarithm); in other
+     * words, brighter values are exponentially more significant/informative
+     * than darker values.
+     */
+    color.r = (uint8_t)(pow((double)intensity / UCHAR_MAX, 3) * 255.0);
+    color.g = 0;
+    color.b = intensity;
+#else  /* not BIN_GRAPH_HEATMAP */
+    color.r = color.g = color.b = intensity;
+#endif /* not BIN_GRAPH_HEATMAP */
 
-    Image* image = alloc_and_init_image(args, bytes);
-    if (image == NULL)
-        return NULL;
+    return color;
+}
+
+uint8_t generate_entropy_intensity(double entropy) {
+    /* Calculate the [00..FF] color intensity based on the [0..8] entropy */
+    return entropy * 255 / 8;
+}
+
+bool generate_entropy_image_init(Image* image, size_t width, size_t height) {
+    if (!image_init(image, IMAGE_FORMAT_INDEXED8, width, height))
+        return false;
+
+    /*
+     * The index of each color is its intensity, since all of them are
+     * different. The padding is black, which is also the color of the zero
+     * intensity.
+     */
+    for (int intensity = 0; intensity <= UCHAR_MAX; intensity++)
+        image_palette_add(&image->palette, intensity_color(intensity));
+    return true;
+}
+
+/*
+ * Data shared by all the threads of 'generate_entropy_rows'.
+ */
+typedef struct {
+    const Args* args;
+    const ByteArray* bytes;
+    Image* image;
+    const EntropyTable* table;
+
+    /*
+     * If not NULL, the intensity of each block is stored here instead of being
+     * rendered, since the pixels of consecutive blocks might overlap.
+     */
+    uint8_t* intensities;
+} EntropyJobData;
+
+/*
+ * Render the entropy of the blocks in the [start..end) range, in block units.
+ * Each block writes to its own pixels, so the ranges can be rendered
+ * concurrently.
+ */
+static void entropy_job(void* data, size_t job, size_t start, size_t end) {
+    UNUSED(job);
+    const EntropyJobData* ctx = data;
+    const Args* args          = ctx->args;
+    const ByteArray* bytes    = ctx->bytes;
+    Image* image              = ctx->image;
 
     /* Iterate blocks of the input, each will share the same entropy color */
-    for (size_t i = 0; i < bytes->size; i += args->block_size) {
+    for (size_t block = start; block < end; block++) {
+        const size_t i = block * args->block_size;
+
         /* Make sure we are not reading past the end of 'bytes->size' */
         const size_t real_block_size = (i + args->block_size < bytes->size)
                                          ? args->block_size
                                          : bytes->size - i;
 
         /* Calculate the Shannon entropy for this block */
-        const double block_entropy = entropy(&bytes->data[i], real_block_size);
+        const double block_entropy =
+          entropy_of_block(ctx->table, &bytes->data[i], real_block_size);
+
+        const uint8_t intensity = generate_entropy_intensity(block_entropy);
+        if (ctx->intensities != NULL) {
+            ctx->intensities[block] = intensity;
+            continue;
+        }
+
+        /* Render this block with the same color */
+        memset(&image->data[i], intensity, real_block_size);
+    }
+}
+
+/*
+ * Render the pixels of a downsampled image from the intensity of each block,
+ * using the maximum intensity of the blocks that overlap each pixel.
+ */
+static void render_downsampled(const Args* args,
+                               const ByteArray* bytes,
+                               size_t samples_per_pixel,
+                               const uint8_t* intensities,
+                               Image* image) {
+    const size_t num_pixels =
+      (bytes->size + samples_per_pixel - 1) / samples_per_pixel;
+    memset(image->data, 0x00, num_pixels);
+
+    const size_t num_blocks =
+      (bytes->size + args->block_size - 1) / args->block_size;
+    for (size_t block = 0; block < num_blocks; block++) {
+        const size_t block_start = block * args->block_size;
+        const size_t block_end =
+          (block_start + args->block_size < bytes->size)
+            ? block_start + args->block_size
+            : bytes->size;
+
+        /* First and last pixels that overlap this block */
+        const size_t first = block_start / samples_per_pixel;
+        const size_t last  = (block_end - 1) / samples_per_pixel;
 
         /*
-         * Calculate the [00..FF] color for this block based on the [0..8]
-         * entropy.
+         * Only the first and last pixels can overlap other blocks, so the
+         * ones in between are simply overwritten.
          */
-        const uint8_t color_intensity = block_entropy * 255 / 8;
+        const uint8_t intensity = intensities[block];
+        if (image->data[first] < intensity)
+            image->data[first] = intensity;
+        if (image->data[last] < intensity)
+            image->data[last] = intensity;
+        if (last > first + 1)
+            memset(&image->data[first + 1], intensity, last - first - 1);
+    }
+}
 
-        /* Render this block with the same color */
-        for (size_t j = 0; j < real_block_size; j++) {
-            Color* color = &image->pixels[i + j];
+bool generate_entropy_rows(const Args* args,
+                           const ByteArray* bytes,
+                           size_t samples_per_pixel,
+                           Image* image) {
+    /* The image must have a pixel for each group of input samples */
+    if (bytes->size > image->width * image->height * samples_per_pixel)
+        return false;
 
-#ifdef BIN_GRAPH_HEATMAP
-            /*
-             * The heatmap visualization uses a linear scale for blue values,
-             * but an exponential scale for red values. This representation is
-             * more closely related to how entropy is calculated (using a base 2
-             * logarithm); in other words, brighter values are exponentially
-             * more significant/informative than darker values.
-             */
-            color->r =
-              (uint8_t)(pow((double)color_intensity / UCHAR_MAX, 3) * 255.0);
-            color->g = 0;
-            color->b = color_intensity;
-#else  /* not BIN_GRAPH_HEATMAP */
-            color->r = color->g = color->b = color_intensity;
-#endif /* not BIN_GRAPH_HEATMAP */
-        }
+    const size_t num_blocks =
+      (bytes->size + args->block_size - 1) / args->block_size;
+
+    uint8_t* intensities = NULL;
+    if (samples_per_pixel > 1) {
+        intensities = malloc(num_blocks);
+        if (intensities == NULL)
+            return false;
+    }
+
+    EntropyTable table;
+    if (!entropy_table_init(&table, args->block_size)) {
+        free(intensities);
+        return false;
+    }
+
+    /* The blocks are independent, so split them across multiple threads */
+    EntropyJobData data = {
+        .args        = args,
+        .bytes       = bytes,
+        .image       = image,
+        .table       = &table,
+        .intensities = intensities,
+    };
+    parallel_for(args->jobs, num_blocks, entropy_job, &data);
+
+    if (intensities != NULL)
+        render_downsampled(args, bytes, samples_per_pixel, intensities, image);
+
+    entropy_table_deinit(&table);
+    free(intensities);
+    return true;
+}
+
+Image* generate_entropy(const Args* args, ByteArray* bytes) {
+    if (!validate_args(args))
+        return NULL;
+
+    const size_t samples_per_pixel =
+      generate_samples_per_pixel(args, bytes->size);
+
+    Image* image = alloc_and_init_image(args, bytes, samples_per_pixel);
+    if (image == NULL)
+        return NULL;
+
+    if (!generate_entropy_rows(args, bytes, samples_per_pixel, image)) {
+        image_deinit(image);
+        free(image);
+        return NULL;
     }
 
     return image;
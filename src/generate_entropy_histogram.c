@@ -19,11 +19,14 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "include/generate.h"
 #include "include/image.h"
 #include "include/args.h"
 #include "include/byte_array.h"
+#include "include/entropy.h"
+#include "include/parallel.h"
 #include "include/util.h"
 
 static bool validate_args(const Args* args) {
@@ -48,7 +51,7 @@ static inline Image* alloc_and_init_image(const Args* args, ByteArray* bytes) {
     if (bytes->size % args->block_size != 0)
         height++;
 
-    if (!image_init(image, width, height))
+    if (!image_init(image, IMAGE_FORMAT_GRAY8, width, height))
         return NULL;
 
     return image;
@@ -56,15 +59,31 @@ static inline Image* alloc_and_init_image(const Args* args, ByteArray* bytes) {
 
 /*----------------------------------------------------------------------------*/
 
-Image* generate_entropy_histogram(const Args* args, ByteArray* bytes) {
-    if (!validate_args(args))
-        return NULL;
-
-    Image* image = alloc_and_init_image(args, bytes);
-    if (image == NULL)
-        return NULL;
+/*
+ * Data shared by all the threads of 'generate_entropy_histogram'.
+ */
+typedef struct {
+    const Args* args;
+    const ByteArray* bytes;
+    Image* image;
+    const EntropyTable* table;
+} EntropyHistogramJobData;
 
-    for (size_t y = 0; y < image->height; y++) {
+/*
+ * Render the rows in the [start..end) range. Each row corresponds to an
+ * independent block, so the ranges can be rendered concurrently.
+ */
+static void entropy_histogram_job(void* data,
+                                  size_t job,
+                                  size_t start,
+                                  size_t end) {
+    UNUSED(job);
+    const EntropyHistogramJobData* ctx = data;
+    const Args* args                   = ctx->args;
+    const ByteArray* bytes             = ctx->bytes;
+    Image* image                       = ctx->image;
+
+    for (size_t y = start; y < end; y++) {
         /* Get the raw data index of the current block */
         const size_t block_start = y * args->block_size;
 
@@ -75,8 +94,9 @@ Image* generate_entropy_histogram(const Args* args, ByteArray* bytes) {
             : bytes->size - block_start;
 
         /* Calculate the Shannon entropy for this block */
-        const double block_entropy =
-          entropy(&bytes->data[block_start], real_block_size);
+        const double block_entropy = entropy_of_block(ctx->table,
+                                                      &bytes->data[block_start],
+                                                      real_block_size);
 
         /*
          * Convert the entropy to a percentage, dividing it by its maximum
@@ -87,15 +107,37 @@ Image* generate_entropy_histogram(const Args* args, ByteArray* bytes) {
         const size_t line_width      = entropy_percent * image->width;
 
 #ifdef BIN_GRAPH_ENTROPY_HISTOGRAM_DOTS
-        Color* color = &image->pixels[image->width * y + line_width];
-        color->r = color->g = color->b = 0xFF;
+        image->data[image->width * y + line_width] = 0xFF;
 #else  /* not BIN_GRAPH_ENTROPY_HISTOGRAM_DOTS */
-        for (size_t x = 0; x < line_width; x++) {
-            Color* color = &image->pixels[image->width * y + x];
-            color->r = color->g = color->b = 0xFF;
-        }
+        memset(&image->data[image->width * y], 0xFF, line_width);
 #endif /* not BIN_GRAPH_ENTROPY_HISTOGRAM_DOTS */
     }
+}
+
+Image* generate_entropy_histogram(const Args* args, ByteArray* bytes) {
+    if (!validate_args(args))
+        return NULL;
+
+    Image* image = alloc_and_init_image(args, bytes);
+    if (image == NULL)
+        return NULL;
+
+    EntropyTable table;
+    if (!entropy_table_init(&table, args->block_size)) {
+        image_deinit(image);
+        free(image);
+        return NULL;
+    }
+
+    /* The blocks are independent, so split the rows across multiple threads */
+    EntropyHistogramJobData data = {
+        .args  = args,
+        .bytes = bytes,
+        .image = image,
+        .table = &table,
+    };
+    parallel_for(args->jobs, image->height, entropy_histogram_job, &data);
 
+    entropy_table_deinit(&table);
     return image;
 }
@@ -17,12 +17,14 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "include/generate.h"
 #include "include/image.h"
 #include "include/args.h"
 #include "include/byte_array.h"
+#include "include/parallel.h"
 #include "include/util.h"
 
 static bool validate_args(const Args* args) {
@@ -34,17 +36,22 @@ static bool validate_args(const Args* args) {
     return true;
 }
 
-static inline Image* alloc_and_init_image(const Args* args, ByteArray* bytes) {
+static inline Image* alloc_and_init_image(const Args* args,
+                                         ByteArray* bytes,
+                                         size_t samples_per_pixel) {
     Image* image = malloc(sizeof(Image));
     if (image == NULL)
         return NULL;
 
+    const size_t num_pixels =
+      (bytes->size + samples_per_pixel - 1) / samples_per_pixel;
+
     size_t width  = args->output_width;
-    size_t height = bytes->size / width;
-    if (bytes->size % width != 0)
+    size_t height = num_pixels / width;
+    if (num_pixels % width != 0)
         height++;
 
-    if (!image_init(image, width, height))
+    if (!generate_grayscale_image_init(image, width, height))
         return NULL;
 
     return image;
@@ -52,38 +59,90 @@ static inline Image* alloc_and_init_image(const Args* args, ByteArray* bytes) {
 
 /*----------------------------------------------------------------------------*/
 
+/*
+ * Data shared by all the threads of 'generate_grayscale_rows'.
+ */
+typedef struct {
+    const ByteArray* bytes;
+    size_t samples_per_pixel;
+    Image* image;
+} GrayscaleJobData;
+
+/*
+ * Render the pixels in the [start..end) range, each with the mean value of its
+ * samples. The last pixel might have less samples than the rest.
+ */
+static void grayscale_mean_job(void* data,
+                               size_t job,
+                               size_t start,
+                               size_t end) {
+    UNUSED(job);
+    const GrayscaleJobData* ctx = data;
+    const ByteArray* bytes      = ctx->bytes;
+    const size_t samples        = ctx->samples_per_pixel;
+
+    for (size_t i = start; i < end; i++) {
+        const size_t first = i * samples;
+        const size_t last =
+          (first + samples < bytes->size) ? first + samples : bytes->size;
+
+        size_t sum = 0;
+        for (size_t j = first; j < last; j++)
+            sum += bytes->data[j];
+
+        /* Round to the nearest value */
+        const size_t count  = last - first;
+        ctx->image->data[i] = (sum + count / 2) / count;
+    }
+}
+
+bool generate_grayscale_rows(const Args* args,
+                             const ByteArray* bytes,
+                             size_t samples_per_pixel,
+                             Image* image) {
+    const size_t num_pixels = image->width * image->height;
+
+    size_t used_pixels =
+      (bytes->size + samples_per_pixel - 1) / samples_per_pixel;
+    if (used_pixels > num_pixels)
+        used_pixels = num_pixels;
+
+    if (samples_per_pixel <= 1) {
+        /* The pixel brightness is determined by the byte value */
+        memcpy(image->data, bytes->data, used_pixels);
+    } else {
+        GrayscaleJobData data = {
+            .bytes             = bytes,
+            .samples_per_pixel = samples_per_pixel,
+            .image             = image,
+        };
+        parallel_for(args->jobs, used_pixels, grayscale_mean_job, &data);
+    }
+
+    /*
+     * If we are not in-bounds, we are filling the last row; use a generic
+     * padding color.
+     */
+    memset(&image->data[used_pixels], 0x00, num_pixels - used_pixels);
+
+    return true;
+}
+
+bool generate_grayscale_image_init(Image* image, size_t width, size_t height) {
+    return image_init(image, IMAGE_FORMAT_GRAY8, width, height);
+}
+
 Image* generate_grayscale(const Args* args, ByteArray* bytes) {
     if (!validate_args(args))
         return NULL;
 
-    Image* image = alloc_and_init_image(args, bytes);
+    const size_t samples_per_pixel =
+      generate_samples_per_pixel(args, bytes->size);
+
+    Image* image = alloc_and_init_image(args, bytes, samples_per_pixel);
     if (image == NULL)
         return NULL;
 
-    for (size_t y = 0; y < image->height; y++) {
-        for (size_t x = 0; x < image->width; x++) {
-            /*
-             * One-dimensional index for both the 'bytes->data' and
-             * 'image->pixels' arrays.
-             */
-            const size_t raw_idx = image->width * y + x;
-
-            /* Pointer to the current color in the Image */
-            Color* color = &image->pixels[raw_idx];
-
-            /*
-             * If we are not in-bounds, we are filling the last row; use a
-             * generic padding color.
-             */
-            if (raw_idx >= bytes->size) {
-                color->r = color->g = color->b = 0x00;
-                continue;
-            }
-
-            /* The color brightness is determined by the byte value */
-            color->r = color->g = color->b = bytes->data[raw_idx];
-        }
-    }
-
+    generate_grayscale_rows(args, bytes, samples_per_pixel, image);
     return image;
 }
@@ -18,12 +18,15 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
 
 #include "include/generate.h"
 #include "include/image.h"
 #include "include/args.h"
 #include "include/byte_array.h"
+#include "include/entropy.h"
+#include "include/parallel.h"
 #include "include/util.h"
 
 static bool validate_args(const Args* args) {
@@ -42,12 +45,33 @@ static inline Image* alloc_and_init_image(const Args* args) {
 
     const size_t width  = args->output_width;
     const size_t height = UCHAR_MAX + 1;
-    if (!image_init(image, width, height))
+    if (!image_init(image, IMAGE_FORMAT_GRAY8, width, height))
         return NULL;
 
     return image;
 }
 
+/*
+ * Data shared by all the threads of 'generate_histogram'.
+ */
+typedef struct {
+    const ByteArray* bytes;
+
+    /* Array of 'ENTROPY_BINS' counters for each job */
+    size_t* occurrences;
+} HistogramJobData;
+
+/*
+ * Count the occurrences of each byte in the [start..end) range of the input,
+ * into the counters of the current job.
+ */
+static void histogram_job(void* data, size_t job, size_t start, size_t end) {
+    const HistogramJobData* ctx = data;
+    entropy_count_bytes(&ctx->bytes->data[start],
+                        end - start,
+                        &ctx->occurrences[ENTROPY_BINS * job]);
+}
+
 /*----------------------------------------------------------------------------*/
 
 Image* generate_histogram(const Args* args, ByteArray* bytes) {
@@ -59,21 +83,32 @@ Image* generate_histogram(const Args* args, ByteArray* bytes) {
         return NULL;
     assert(image->height == UCHAR_MAX + 1);
 
-    size_t* occurrences = calloc(UCHAR_MAX + 1, sizeof(size_t));
-    if (occurrences == NULL)
-        return NULL;
-
     /*
-     * Count the number of occurrences of each byte, also storing which is the
-     * most frequent byte.
+     * Count the number of occurrences of each byte on multiple threads, each
+     * with its own counters, and merge them.
      */
+    const size_t jobs = parallel_get_jobs(args->jobs, bytes->size);
+    HistogramJobData data = {
+        .bytes       = bytes,
+        .occurrences = calloc(jobs * ENTROPY_BINS, sizeof(size_t)),
+    };
+    if (data.occurrences == NULL) {
+        image_deinit(image);
+        free(image);
+        return NULL;
+    }
+    parallel_for(jobs, bytes->size, histogram_job, &data);
+
+    size_t* occurrences = data.occurrences;
+    for (size_t job = 1; job < jobs; job++)
+        for (int byte = 0; byte < ENTROPY_BINS; byte++)
+            occurrences[byte] += data.occurrences[ENTROPY_BINS * job + byte];
+
+    /* Store which is the most frequent byte */
     uint8_t most_frequent = 0;
-    for (size_t i = 0; i < bytes->size; i++) {
-        const uint8_t byte = bytes->data[i];
-        occurrences[byte]++;
+    for (int byte = 0; byte < ENTROPY_BINS; byte++)
         if (occurrences[byte] > occurrences[most_frequent])
             most_frequent = byte;
-    }
 
     /*
      * Draw each horizontal line based on occurrences relative to the most
@@ -83,10 +118,7 @@ Image* generate_histogram(const Args* args, ByteArray* bytes) {
         const size_t line_width =
           occurrences[y] * image->width / occurrences[most_frequent];
 
-        for (size_t x = 0; x < line_width; x++) {
-            Color* color = &image->pixels[image->width * y + x];
-            color->r = color->g = color->b = 0xFF;
-        }
+        memset(&image->data[image->width * y], 0xFF, line_width);
     }
 
     free(occurrences);
@@ -0,0 +1,209 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "include/generate.h"
+#include "include/image.h"
+#include "include/args.h"
+#include "include/byte_array.h"
+#include "include/entropy.h"
+#include "include/parallel.h"
+#include "include/util.h"
+
+/*
+ * Minimum number of samples in each segment of the input. The window is
+ * rebuilt from scratch at the start of each segment, so the floating point
+ * error of the incremental updates doesn't accumulate over the whole input, and
+ * the segments can be processed independently by different threads.
+ */
+#define MIN_SEGMENT_SIZE 0x4000
+
+/*
+ * Data shared by all the threads of 'generate_sliding_entropy'.
+ */
+typedef struct {
+    const Args* args;
+    const ByteArray* bytes;
+    Image* image;
+    const EntropyTable* table;
+    size_t segment_size;
+} SlidingEntropyJobData;
+
+/*----------------------------------------------------------------------------*/
+
+static bool validate_args(const Args* args) {
+    if (args->block_size <= 1) {
+        ERR("The current block size (%zu) is too small for the current mode "
+            "(%s).",
+            args->block_size,
+            args_get_mode_name(args->mode));
+        return false;
+    }
+    return true;
+}
+
+static inline Image* alloc_and_init_image(const Args* args, ByteArray* bytes) {
+    Image* image = malloc(sizeof(Image));
+    if (image == NULL)
+        return NULL;
+
+    size_t width  = args->output_width;
+    size_t height = bytes->size / width;
+    if (bytes->size % width != 0)
+        height++;
+
+    /* Same pixel format and palette as the "entropy" mode */
+    if (!generate_entropy_image_init(image, width, height))
+        return NULL;
+
+    return image;
+}
+
+/*
+ * Add or remove an occurrence of the specified byte from the window, updating
+ * the sum of 'c*log2(c)' for all the counts 'c' in the window.
+ */
+static inline void window_add(const EntropyTable* table,
+                              size_t occurrences[ENTROPY_BINS],
+                              double* sum,
+                              uint8_t byte) {
+    const size_t count = occurrences[byte]++;
+    *sum += entropy_table_get(table, count + 1) -
+            entropy_table_get(table, count);
+}
+
+static inline void window_remove(const EntropyTable* table,
+                                 size_t occurrences[ENTROPY_BINS],
+                                 double* sum,
+                                 uint8_t byte) {
+    const size_t count = occurrences[byte]--;
+    *sum += entropy_table_get(table, count - 1) -
+            entropy_table_get(table, count);
+}
+
+/*
+ * Render the samples of the segments in the [start..end) range.
+ */
+static void sliding_entropy_job(void* data,
+                                size_t job,
+                                size_t start,
+                                size_t end) {
+    UNUSED(job);
+    const SlidingEntropyJobData* ctx = data;
+    const EntropyTable* table        = ctx->table;
+    const uint8_t* input             = ctx->bytes->data;
+    const size_t input_size          = ctx->bytes->size;
+
+    /*
+     * The window of each sample 'i' is '[i - half_before, i + half_after)',
+     * limited to the bounds of the input.
+     */
+    const size_t half_before = ctx->args->block_size / 2;
+    const size_t half_after  = ctx->args->block_size - half_before;
+
+    for (size_t segment = start; segment < end; segment++) {
+        const size_t first = segment * ctx->segment_size;
+        size_t last        = first + ctx->segment_size;
+        if (last > input_size)
+            last = input_size;
+
+        /* Build the window of the first sample from scratch */
+        size_t window_start =
+          (first > half_before) ? first - half_before : 0;
+        size_t window_end = first + half_after;
+        if (window_end > input_size)
+            window_end = input_size;
+
+        size_t occurrences[ENTROPY_BINS] = { 0 };
+        entropy_count_bytes(&input[window_start],
+                            window_end - window_start,
+                            occurrences);
+
+        double sum = 0.0;
+        for (int byte = 0; byte < ENTROPY_BINS; byte++)
+            sum += entropy_table_get(table, occurrences[byte]);
+
+        for (size_t i = first; i < last; i++) {
+            /*
+             * Slide the window one sample to the right, removing the sample
+             * that is now too far behind, and adding the new one.
+             */
+            if (i > first) {
+                if (i > half_before)
+                    window_remove(table,
+                                  occurrences,
+                                  &sum,
+                                  input[window_start++]);
+                if (window_end < input_size)
+                    window_add(table, occurrences, &sum, input[window_end++]);
+            }
+
+            /* See 'entropy_of_block' for the formula */
+            const size_t window_size = window_end - window_start;
+            double window_entropy =
+              (entropy_table_get(table, window_size) - sum) / window_size;
+            if (window_entropy < 0.0)
+                window_entropy = 0.0;
+
+            ctx->image->data[i] = generate_entropy_intensity(window_entropy);
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+Image* generate_sliding_entropy(const Args* args, ByteArray* bytes) {
+    if (!validate_args(args))
+        return NULL;
+
+    Image* image = alloc_and_init_image(args, bytes);
+    if (image == NULL)
+        return NULL;
+
+    EntropyTable table;
+    if (!entropy_table_init(&table, args->block_size)) {
+        image_deinit(image);
+        free(image);
+        return NULL;
+    }
+
+    /*
+     * Rebuilding the window costs as much as sliding it through a whole
+     * window, so make sure that the segments are at least that big.
+     */
+    const size_t segment_size = (args->block_size > MIN_SEGMENT_SIZE)
+                                  ? args->block_size
+                                  : MIN_SEGMENT_SIZE;
+    const size_t num_segments =
+      (bytes->size + segment_size - 1) / segment_size;
+
+    SlidingEntropyJobData data = {
+        .args         = args,
+        .bytes        = bytes,
+        .image        = image,
+        .table        = &table,
+        .segment_size = segment_size,
+    };
+    parallel_for(args->jobs, num_segments, sliding_entropy_job, &data);
+
+    entropy_table_deinit(&table);
+    return image;
+}
@@ -16,30 +16,265 @@
  * this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include "include/image.h"
 #include "include/args.h"
 #include "include/byte_array.h"
 #include "include/util.h"
 
-bool image_init(Image* image, size_t width, size_t height) {
+/*
+ * Create an unlinked temporary file of the specified size, and map it into
+ * memory. The file is removed by the system once it's unmapped. Returns NULL
+ * on failure.
+ */
+static uint8_t* map_temporary_file(size_t size) {
+    const char* dir = getenv("TMPDIR");
+    if (dir == NULL || *dir == '\0')
+        dir = "/tmp";
+
+    char path[FILENAME_MAX];
+    if (snprintf(path, sizeof(path), "%s/bin-graph-XXXXXX", dir) >=
+        (int)sizeof(path))
+        return NULL;
+
+    const int fd = mkstemp(path);
+    if (fd < 0)
+        return NULL;
+    unlink(path);
+
+    /* The extended file reads as zeros, like 'calloc' */
+    void* mapping = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0)
+        mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return (mapping == MAP_FAILED) ? NULL : mapping;
+}
+
+bool image_init(Image* image,
+                enum EImageFormat format,
+                size_t width,
+                size_t height) {
+    assert(image != NULL);
+
+    image->format       = format;
+    image->width        = width;
+    image->height       = height;
+    image->mapping_size = 0;
+    image_palette_init(&image->palette);
+
+    const size_t size = width * height * image_pixel_size(format);
+    if (size < IMAGE_MAPPED_MIN_SIZE) {
+        image->data = calloc(size, 1);
+        return image->data != NULL;
+    }
+
+    image->data = map_temporary_file(size);
+    if (image->data == NULL) {
+        ERR("Failed to map a temporary file of %zu bytes for the image.",
+            size);
+        return false;
+    }
+
+    image->mapping_size = size;
+    return true;
+}
+
+bool image_convert_to_rgb(Image* image) {
     assert(image != NULL);
 
-    image->width  = width;
-    image->height = height;
+    if (image->format == IMAGE_FORMAT_RGB24)
+        return true;
+
+    Image rgb_image;
+    if (!image_init(&rgb_image, IMAGE_FORMAT_RGB24, image->width, image->height))
+        return false;
+
+    Color* new_pixels       = (Color*)rgb_image.data;
+    const size_t num_pixels = image->width * image->height;
+    for (size_t i = 0; i < num_pixels; i++)
+        new_pixels[i] = image_get_color(image, i);
+
+    image_deinit(image);
+    *image = rgb_image;
+    return true;
+}
+
+/*
+ * Check if the pixels of two images have the same meaning, that is, if they
+ * can be copied from one image to the other without any conversion.
+ */
+static bool formats_match(const Image* a, const Image* b) {
+    if (a->format != b->format)
+        return false;
+    if (a->format != IMAGE_FORMAT_INDEXED8)
+        return true;
+
+    return a->palette.size == b->palette.size &&
+           memcmp(a->palette.colors,
+                  b->palette.colors,
+                  a->palette.size * sizeof(Color)) == 0;
+}
+
+bool image_append(Image* dst, const Image* src) {
+    assert(dst != NULL && src != NULL);
 
-    image->pixels = calloc(image->height * image->width, sizeof(Color));
-    if (image->pixels == NULL)
+    /*
+     * If the pixels of both images have different meanings, use RGB for the
+     * destination, and convert each source pixel below.
+     */
+    const bool must_convert = !formats_match(dst, src);
+    if (must_convert && !image_convert_to_rgb(dst))
         return false;
 
+    const size_t pixel_size = image_pixel_size(dst->format);
+    const size_t new_width  = (dst->width > src->width) ? dst->width
+                                                        : src->width;
+    const size_t new_height = dst->height + src->height;
+
+    const size_t new_size   = new_width * new_height * pixel_size;
+
+    uint8_t* new_data;
+    if (new_width == dst->width && dst->mapping_size == 0 &&
+        new_size < IMAGE_MAPPED_MIN_SIZE) {
+        /* The old rows don't need to move, just make room for the new ones */
+        new_data = realloc(dst->data, new_size);
+        if (new_data == NULL)
+            return false;
+    } else {
+        Image new_image;
+        if (!image_init(&new_image, dst->format, new_width, new_height))
+            return false;
+        new_data = new_image.data;
+
+        for (size_t y = 0; y < dst->height; y++)
+            memcpy(&new_data[new_width * y * pixel_size],
+                   &dst->data[dst->width * y * pixel_size],
+                   dst->width * pixel_size);
+
+        image_deinit(dst);
+        dst->mapping_size = new_image.mapping_size;
+    }
+
+    /* Copy the new rows, filling the remaining pixels of each row with black */
+    for (size_t y = 0; y < src->height; y++) {
+        uint8_t* row = &new_data[new_width * (dst->height + y) * pixel_size];
+        if (must_convert) {
+            Color* row_pixels = (Color*)row;
+            for (size_t x = 0; x < src->width; x++)
+                row_pixels[x] = image_get_color(src, src->width * y + x);
+        } else {
+            memcpy(row,
+                   &src->data[src->width * y * pixel_size],
+                   src->width * pixel_size);
+        }
+        memset(&row[src->width * pixel_size],
+               0,
+               (new_width - src->width) * pixel_size);
+    }
+
+    dst->data   = new_data;
+    dst->width  = new_width;
+    dst->height = new_height;
     return true;
 }
 
 void image_deinit(Image* image) {
-    free(image->pixels);
-    image->pixels = NULL;
+    if (image->mapping_size != 0)
+        munmap(image->data, image->mapping_size);
+    else
+        free(image->data);
+
+    image->data         = NULL;
+    image->mapping_size = 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Get the initial slot of a color in the hash table of an 'ImagePalette'.
+ */
+static inline size_t palette_hash(Color color) {
+    const uint32_t key = ((uint32_t)color.r << 16) | (color.g << 8) | color.b;
+    return ((key * 0x9E3779B1u) >> 16) & (IMAGE_PALETTE_HASH_SIZE - 1);
+}
+
+/*
+ * Get the slot used by the specified color, or the empty slot where it should
+ * be inserted. Since the table has more slots than colors, there is always an
+ * empty slot.
+ */
+static size_t palette_find_slot(const ImagePalette* palette, Color color) {
+    size_t slot = palette_hash(color);
+    while (palette->slots[slot] >= 0 &&
+           !colors_equal(palette->colors[palette->slots[slot]], color))
+        slot = (slot + 1) & (IMAGE_PALETTE_HASH_SIZE - 1);
+    return slot;
+}
+
+void image_palette_init(ImagePalette* palette) {
+    palette->size = 0;
+    for (size_t i = 0; i < IMAGE_PALETTE_HASH_SIZE; i++)
+        palette->slots[i] = -1;
+}
+
+int image_palette_find(const ImagePalette* palette, Color color) {
+    return palette->slots[palette_find_slot(palette, color)];
+}
+
+bool image_palette_add(ImagePalette* palette, Color color) {
+    const size_t slot = palette_find_slot(palette, color);
+    if (palette->slots[slot] >= 0)
+        return true;
+    if (palette->size >= IMAGE_PALETTE_MAX_SIZE)
+        return false;
+
+    palette->slots[slot]             = palette->size;
+    palette->colors[palette->size++] = color;
+    return true;
+}
+
+bool image_get_palette(const Image* image, ImagePalette* palette) {
+    image_palette_init(palette);
+
+    const size_t num_pixels = image->width * image->height;
+    if (image->format != IMAGE_FORMAT_RGB24) {
+        /* Single-byte formats have at most 256 colors, just mark the used ones */
+        bool used[256] = { false };
+        for (size_t i = 0; i < num_pixels; i++)
+            used[image->data[i]] = true;
+
+        for (size_t value = 0; value < 256; value++) {
+            if (!used[value])
+                continue;
+            const Color color =
+              (image->format == IMAGE_FORMAT_GRAY8)
+                ? (Color){ value, value, value }
+                : image->palette.colors[value];
+            image_palette_add(palette, color);
+        }
+        return true;
+    }
+
+    /* Consecutive pixels usually have the same color, avoid looking it up */
+    const Color* pixels = (const Color*)image->data;
+    for (size_t i = 0; i < num_pixels; i++) {
+        if (i > 0 && colors_equal(pixels[i], pixels[i - 1]))
+            continue;
+        if (!image_palette_add(palette, pixels[i]))
+            return false;
+    }
+
+    return true;
 }
@@ -26,6 +26,10 @@
 #define ARGS_DEFAULT_BLOCK_SIZE 256
 #endif /* ARGS_DEFAULT_BLOCK_SIZE */
 
+#ifndef ARGS_DEFAULT_KGRAM_SIZE
+#define ARGS_DEFAULT_KGRAM_SIZE 8
+#endif /* ARGS_DEFAULT_KGRAM_SIZE */
+
 #ifndef ARGS_DEFAULT_OUTPUT_WIDTH
 #define ARGS_DEFAULT_OUTPUT_WIDTH 512
 #endif /* ARGS_DEFAULT_OUTPUT_WIDTH */
@@ -34,23 +38,79 @@
 #define ARGS_DEFAULT_OUTPUT_ZOOM 2
 #endif /* ARGS_DEFAULT_OUTPUT_ZOOM */
 
+#ifndef ARGS_DEFAULT_JOBS
+#define ARGS_DEFAULT_JOBS 0 /* Number of online processors */
+#endif /* ARGS_DEFAULT_JOBS */
+
+#ifndef ARGS_MAX_REGIONS
+#define ARGS_MAX_REGIONS 64
+#endif /* ARGS_MAX_REGIONS */
+
+#ifndef ARGS_MAX_TRANSFORMS
+#define ARGS_MAX_TRANSFORMS 8
+#endif /* ARGS_MAX_TRANSFORMS */
+
 enum EArgsMode {
     ARGS_MODE_GRAYSCALE,
     ARGS_MODE_ASCII,
     ARGS_MODE_ENTROPY,
     ARGS_MODE_ENTROPY_HISTOGRAM,
+    ARGS_MODE_SLIDING_ENTROPY,
     ARGS_MODE_HISTOGRAM,
     ARGS_MODE_BIGRAMS,
     ARGS_MODE_DOTPLOT,
+    ARGS_MODE_DOTPLOT_DENSITY,
+    ARGS_MODE_DOTPLOT_KGRAM,
 };
 
 enum EArgsOutputFormat {
     ARGS_OUTPUT_FORMAT_PNG,
     ARGS_OUTPUT_FORMAT_ESC_TEXT,
+    ARGS_OUTPUT_FORMAT_ESC_TEXT_HALF,
+    ARGS_OUTPUT_FORMAT_SIXEL,
+    ARGS_OUTPUT_FORMAT_KITTY,
+    ARGS_OUTPUT_FORMAT_PPM,
+    ARGS_OUTPUT_FORMAT_PAM,
+    ARGS_OUTPUT_FORMAT_DZI,
+};
+
+enum EArgsPngCompression {
+    ARGS_PNG_COMPRESSION_FAST,
+    ARGS_PNG_COMPRESSION_DEFAULT,
+    ARGS_PNG_COMPRESSION_BEST,
+};
+
+enum EArgsScale {
+    ARGS_SCALE_LINEAR,
+    ARGS_SCALE_LOG,
+};
+
+enum EArgsTransform {
+    ARGS_TRANSFORM_SQUARES,
+    ARGS_TRANSFORM_ZIGZAG,
+    ARGS_TRANSFORM_HILBERT,
+    ARGS_TRANSFORM_MORTON,
 };
 
 /*----------------------------------------------------------------------------*/
 
+/*
+ * Range of the input file that should be processed. The end offset is not
+ * inclusive, and zero means the end of the file.
+ */
+typedef struct ArgsRegion {
+    size_t start, end;
+} ArgsRegion;
+
+/*
+ * Transformation applied to the generated image, along with its parameter
+ * (e.g. the side of the squares, or the recursion level of a curve).
+ */
+typedef struct ArgsTransform {
+    enum EArgsTransform type;
+    size_t param;
+} ArgsTransform;
+
 /*
  * Structure filled by 'args_parse' to indicate the program's command-line
  * arguments.
@@ -66,34 +126,59 @@ typedef struct args {
     /* Block size used in some modes like 'ARGS_MODE_ENTROPY' */
     size_t block_size;
 
+    /* Length of the sequences compared by 'ARGS_MODE_DOTPLOT_KGRAM' */
+    size_t kgram_size;
+
+    /* Scale used for the intensity of the modes that count occurrences */
+    enum EArgsScale scale;
+
+    /*
+     * Maximum number of threads used by the modes that support it. Zero means
+     * the number of online processors.
+     */
+    size_t jobs;
+
     /* Output format */
     enum EArgsOutputFormat output_format;
 
     /* Width in pixels of the output image (before applying the zoom) */
     int output_width;
 
+    /*
+     * Maximum height and number of pixels of the output image (before applying
+     * the zoom) in the modes that support downsampling. Zero means no limit.
+     */
+    size_t max_height, max_pixels;
+
     /* Start and end offsets for reading the input file. Zero means ignore. */
     size_t offset_start, offset_end;
 
+    /*
+     * Input ranges that will be processed, in order. Each region generates its
+     * own image, and they are stacked vertically in the output. If no region
+     * was specified, it contains a single region with the offsets above.
+     */
+    ArgsRegion regions[ARGS_MAX_REGIONS];
+    size_t regions_num;
+
     /* Width and height of each "pixel" when drawn in the actual PNG image */
     int output_zoom;
 
-    /*
-     * Side of each square used when transforming the generated image. Values
-     * lower than two are ignored.
-     */
-    int transform_squares_side;
+    /* Filtering and compression preset used when exporting PNG images */
+    enum EArgsPngCompression png_compression;
 
     /*
-     * True if the image should be transforming with the "ZigZag" method.
+     * Transformations applied to the generated image, in order. Each of them
+     * receives the output of the previous one as a linear image.
      */
-    bool transform_zigzag;
+    ArgsTransform transforms[ARGS_MAX_TRANSFORMS];
+    size_t transforms_num;
 
     /*
-     * Recursion level when transforming the image through the space-filling
-     * Hilbert curve.
+     * Directory where the offsets of the transformation layouts are cached
+     * between runs, or NULL if they should always be computed.
      */
-    int transform_hilbert_level;
+    const char* layout_cache_dir;
 } Args;
 
 /*----------------------------------------------------------------------------*/
@@ -119,4 +204,9 @@ const char* args_get_mode_name(enum EArgsMode mode);
  */
 const char* args_get_output_format_name(enum EArgsOutputFormat format);
 
+/*
+ * Get the name of the specified transformation enumerator.
+ */
+const char* args_get_transform_name(enum EArgsTransform type);
+
 #endif /* ARGS_H_ */
@@ -26,6 +26,14 @@
 typedef struct ByteArray {
     uint8_t* data;
     size_t size;
+
+    /*
+     * If not NULL, the 'data' member points inside this read-only memory
+     * mapping, of 'mapping_size' bytes, instead of a heap buffer. See
+     * 'byte_array_map'.
+     */
+    void* mapping;
+    size_t mapping_size;
 } ByteArray;
 
 /*
@@ -37,6 +45,18 @@ typedef struct ByteArray {
  */
 bool byte_array_init(ByteArray* array, size_t size);
 
+/*
+ * Initialize a 'ByteArray' structure as a read-only view of the file with the
+ * specified descriptor, from 'offset' to 'offset + size'. The file is mapped
+ * into memory instead of being copied, so the 'data' member must not be
+ * written or resized. This function returns true on success, or false
+ * otherwise.
+ *
+ * The caller is responsible for deinitializing the structure with
+ * 'byte_array_destroy'.
+ */
+bool byte_array_map(ByteArray* array, int fd, size_t offset, size_t size);
+
 /*
  * Resize a 'ByteArray' structure to the specified size. This function returns
  * true on success, or false otherwise.
@@ -44,8 +64,8 @@ bool byte_array_init(ByteArray* array, size_t size);
 bool byte_array_resize(ByteArray* array, size_t new_size);
 
 /*
- * Destroy a 'ByteArray' structure, freeing its members. Doesn't free the
- * 'ByteArray' structure itself.
+ * Destroy a 'ByteArray' structure, freeing or unmapping its members. Doesn't
+ * free the 'ByteArray' structure itself.
  */
 void byte_array_destroy(ByteArray* array);
 
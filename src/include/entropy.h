@@ -0,0 +1,106 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENTROPY_H_
+#define ENTROPY_H_ 1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <math.h> /* log2() */
+
+/*
+ * Maximum value returned by a function that calculates the entropy of an array
+ * of bytes using a base 2 logarithm. For more information, see:
+ * https://8dcc.github.io/programming/understanding-entropy.html#entropy-range
+ */
+#define MAX_ENTROPY 8.0
+
+/*
+ * Number of possible byte values, and therefore of histogram bins.
+ */
+#define ENTROPY_BINS (UCHAR_MAX + 1)
+
+/*
+ * Maximum number of entries stored in an 'EntropyTable'. Bigger counts are
+ * calculated on the fly.
+ */
+#ifndef ENTROPY_MAX_TABLE_SIZE
+#define ENTROPY_MAX_TABLE_SIZE 0x100000
+#endif /* ENTROPY_MAX_TABLE_SIZE */
+
+/*
+ * Precomputed 'n*log2(n)' values for every possible number of occurrences of a
+ * byte in a block of a fixed size, so the entropy of each block can be
+ * calculated without any logarithms. Read-only once initialized, so it can be
+ * shared between threads.
+ */
+typedef struct EntropyTable {
+    double* nlogn;
+    size_t size;
+} EntropyTable;
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Initialize an 'EntropyTable' for blocks of up to 'block_size' bytes. This
+ * function returns true on success, or false otherwise.
+ *
+ * The caller is responsible for deinitializing the table with
+ * 'entropy_table_deinit'.
+ */
+bool entropy_table_init(EntropyTable* table, size_t block_size);
+
+/*
+ * Free all members of an 'EntropyTable' structure. Doesn't free the structure
+ * itself.
+ */
+void entropy_table_deinit(EntropyTable* table);
+
+/*
+ * Get the value of 'n*log2(n)' from the table, or calculate it if the table is
+ * not big enough.
+ */
+static inline double entropy_table_get(const EntropyTable* table, size_t n) {
+    if (n < table->size)
+        return table->nlogn[n];
+    return (double)n * log2((double)n);
+}
+
+/*
+ * Count the occurrences of each byte value in the specified data, adding them
+ * to the 'occurrences' array, which should be initialized by the caller.
+ */
+void entropy_count_bytes(const void* data,
+                         size_t data_sz,
+                         size_t occurrences[ENTROPY_BINS]);
+
+/*
+ * Calculate the Shannon entropy of the specified bytes, using the precomputed
+ * values of the specified table. Since the base 2 logarithm is used, the return
+ * value is in the [0..8] range.
+ *
+ * For more information, see my article about entropy:
+ * https://8dcc.github.io/programming/understanding-entropy.html
+ */
+double entropy_of_block(const EntropyTable* table,
+                        const void* data,
+                        size_t data_sz);
+
+#endif /* ENTROPY_H_ */
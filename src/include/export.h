@@ -19,7 +19,9 @@
 #ifndef EXPORT_H_
 #define EXPORT_H_ 1
 
+#include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h> /* FILE */
 
 #include "image.h"
@@ -38,9 +40,125 @@ bool export_png(const Args* args, const Image* image, FILE* output_fp);
 
 /*
  * Export the specified 'Image' structure as ANSI-escaped colored text into the
- * specified text file or terminal.
+ * specified text file or terminal. The second function draws two rows of pixels
+ * in each line, using half block characters.
  */
 bool export_escaped_text(const Args* args, const Image* image, FILE* output_fp);
+bool export_escaped_text_half(const Args* args,
+                              const Image* image,
+                              FILE* output_fp);
+
+/*
+ * Export the specified 'Image' structure as an image for terminals that support
+ * sixel graphics, or the kitty graphics protocol, respectively. Sixel images
+ * use up to 256 colors, while kitty images contain compressed RGB pixels.
+ */
+bool export_sixel(const Args* args, const Image* image, FILE* output_fp);
+bool export_kitty(const Args* args, const Image* image, FILE* output_fp);
+
+/*
+ * Export the specified 'Image' structure into the specified Netpbm file,
+ * without any compression. PPM files always contain RGB pixels, while PAM
+ * files contain a single channel if all the colors of the image are gray.
+ */
+bool export_ppm(const Args* args, const Image* image, FILE* output_fp);
+bool export_pam(const Args* args, const Image* image, FILE* output_fp);
+
+/*
+ * Export the specified 'Image' structure as a Deep Zoom pyramid of PNG tiles.
+ * The specified file receives the XML manifest, and the tiles are written into
+ * a directory next to it, named after the manifest.
+ */
+bool export_dzi(const Args* args, const Image* image, FILE* output_fp);
+
+/*
+ * Context for exporting an image in consecutive groups of rows, without having
+ * the whole 'Image' in memory at once.
+ */
+typedef struct ExportStream {
+    const Args* args;
+    FILE* output_fp;
+
+    /* Dimensions of the whole image, before applying the zoom */
+    size_t width, height;
+
+    /* Number of rows exported so far, before applying the zoom */
+    size_t rows_written;
+
+    /* Pixel format of all the exported rows */
+    enum EImageFormat format;
+
+    /*
+     * For 'IMAGE_FORMAT_INDEXED8' images, the colors of each index. Otherwise,
+     * all the colors that might appear in the image, or NULL if they are not
+     * known. Some formats use it for a more compact output.
+     */
+    const ImagePalette* palette;
+
+    /* Data specific to each output format, initially NULL */
+    void* data;
+} ExportStream;
+
+/*
+ * Pointer to a function that exports the next rows of an image, whose width
+ * must match the one in the 'ExportStream'. After the last rows, the function
+ * must be called once with a NULL 'rows' argument to finish the output and free
+ * the format-specific data. If the function fails, the stream is finished and
+ * must not be used again.
+ */
+typedef bool (*export_rows_func_ptr_t)(ExportStream* stream, const Image* rows);
+
+/*
+ * Export the next rows of an image into a PNG file, or an ANSI-escaped text
+ * file with one or two rows of pixels per line, respectively.
+ */
+bool export_png_rows(ExportStream* stream, const Image* rows);
+bool export_escaped_text_rows(ExportStream* stream, const Image* rows);
+bool export_escaped_text_half_rows(ExportStream* stream, const Image* rows);
+
+/*
+ * Export the next rows of an image as sixel graphics, or with the kitty
+ * graphics protocol, respectively.
+ */
+bool export_sixel_rows(ExportStream* stream, const Image* rows);
+bool export_kitty_rows(ExportStream* stream, const Image* rows);
+
+/*
+ * Export the next rows of an image into a PPM or a PAM file, respectively.
+ */
+bool export_ppm_rows(ExportStream* stream, const Image* rows);
+bool export_pam_rows(ExportStream* stream, const Image* rows);
+
+/*
+ * Export the next rows of an image into a Deep Zoom pyramid. Each level is
+ * downsampled from the next one as the rows are received, so only a band of
+ * tiles of each level is kept in memory.
+ */
+bool export_dzi_rows(ExportStream* stream, const Image* rows);
+
+/*
+ * Export a whole image through the specified row export function, as a single
+ * group of rows. The 'palette' argument contains all the colors of the image,
+ * or is NULL if they are not known. It's ignored for indexed images, which use
+ * their own palette.
+ */
+bool export_image_through_rows(export_rows_func_ptr_t export_rows_func,
+                               const Args* args,
+                               const Image* image,
+                               const ImagePalette* palette,
+                               FILE* output_fp);
+
+/*
+ * Write the row 'y' of an image into 'dst', scaling it horizontally by the
+ * specified zoom. If 'is_gray' is true, each pixel is written as a single byte
+ * with its red channel, which should only be used for images whose colors are
+ * all gray. Otherwise, each pixel is written as 3 bytes, in RGB order.
+ */
+void export_build_zoomed_row(const Image* image,
+                             size_t y,
+                             int zoom,
+                             bool is_gray,
+                             uint8_t* dst);
 
 /*----------------------------------------------------------------------------*/
 
@@ -54,6 +172,45 @@ static inline export_func_ptr_t export_func_from_output_format(
             return export_png;
         case ARGS_OUTPUT_FORMAT_ESC_TEXT:
             return export_escaped_text;
+        case ARGS_OUTPUT_FORMAT_ESC_TEXT_HALF:
+            return export_escaped_text_half;
+        case ARGS_OUTPUT_FORMAT_SIXEL:
+            return export_sixel;
+        case ARGS_OUTPUT_FORMAT_KITTY:
+            return export_kitty;
+        case ARGS_OUTPUT_FORMAT_PPM:
+            return export_ppm;
+        case ARGS_OUTPUT_FORMAT_PAM:
+            return export_pam;
+        case ARGS_OUTPUT_FORMAT_DZI:
+            return export_dzi;
+    }
+    return NULL;
+}
+
+/*
+ * Return a pointer to the row export function associated to a specific mode,
+ * or NULL if the output format can't be exported in groups of rows.
+ */
+static inline export_rows_func_ptr_t export_rows_func_from_output_format(
+  enum EArgsOutputFormat format) {
+    switch (format) {
+        case ARGS_OUTPUT_FORMAT_PNG:
+            return export_png_rows;
+        case ARGS_OUTPUT_FORMAT_ESC_TEXT:
+            return export_escaped_text_rows;
+        case ARGS_OUTPUT_FORMAT_ESC_TEXT_HALF:
+            return export_escaped_text_half_rows;
+        case ARGS_OUTPUT_FORMAT_SIXEL:
+            return export_sixel_rows;
+        case ARGS_OUTPUT_FORMAT_KITTY:
+            return export_kitty_rows;
+        case ARGS_OUTPUT_FORMAT_PPM:
+            return export_ppm_rows;
+        case ARGS_OUTPUT_FORMAT_PAM:
+            return export_pam_rows;
+        case ARGS_OUTPUT_FORMAT_DZI:
+            return export_dzi_rows;
     }
     return NULL;
 }
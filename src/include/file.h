@@ -23,6 +23,7 @@
 #include <stdbool.h>
 #include <stdio.h> /* FILE */
 
+#include "args.h"
 #include "byte_array.h"
 
 /*
@@ -45,10 +46,38 @@ enum EFileOpenMode {
  */
 FILE* file_open(const char* path, enum EFileOpenMode mode);
 
+/*
+ * Create a directory at the specified path, unless it already exists. This
+ * function returns true on success, or false otherwise.
+ */
+bool file_make_dir(const char* path);
+
+/*
+ * Move the file position forward by the specified number of bytes. Seekable
+ * files are moved directly, while other files (e.g. pipes) are read in large
+ * blocks, discarding the data. Reaching the end of the file is not considered
+ * an error. This function returns true on success, or false otherwise.
+ */
+bool file_skip(FILE* fp, size_t bytes);
+
+/*
+ * Calculate the number of bytes that 'file_read' would read with the same
+ * arguments, without reading them, and store it in 'out'. This function returns
+ * false if the size can't be determined (e.g. because the file is a pipe).
+ */
+bool file_region_size(FILE* fp,
+                      size_t offset_start,
+                      size_t offset_end,
+                      size_t* out);
+
 /*
  * Read the bytes of a file in a linear way from the starting offset to the end
  * offset. This function returns true on success, or false otherwise.
  *
+ * Regular files are mapped into memory as a read-only 'ByteArray' view instead
+ * of being copied, so the resulting bytes must not be modified. In either case,
+ * the caller is responsible for destroying the array with 'byte_array_destroy'.
+ *
  * Note that this function expects the file position to be on the first byte,
  * that is, the 'offset_start' and 'offset_end' arguments are actually relative
  * to the current file position.
@@ -58,4 +87,19 @@ bool file_read(ByteArray* dst,
                size_t offset_start,
                size_t offset_end);
 
+/*
+ * Read each of the specified regions of a file into the 'dsts' array, which
+ * should have at least 'regions_num' elements. The offsets of each region are
+ * relative to the current file position, just like in 'file_read'. This
+ * function returns true on success, or false otherwise.
+ *
+ * Seekable files are positioned at the start of each region directly, so the
+ * bytes between regions are never read. Other files (e.g. pipes) are only read
+ * once, and each region is copied from there.
+ */
+bool file_read_regions(ByteArray* dsts,
+                       FILE* fp,
+                       const ArgsRegion* regions,
+                       size_t regions_num);
+
 #endif /* FILE_H_ */
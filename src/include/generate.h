@@ -19,6 +19,9 @@
 #ifndef GENERATE_H_
 #define GENERATE_H_ 1
 
+#include <stdint.h>
+#include <math.h> /* log1p() */
+
 #include "args.h"       /* Args */
 #include "byte_array.h" /* ByteArray */
 #include "image.h"      /* Image */
@@ -43,12 +46,125 @@ Image* generate_grayscale(const Args* args, ByteArray* bytes);
 Image* generate_ascii(const Args* args, ByteArray* bytes);
 Image* generate_entropy(const Args* args, ByteArray* bytes);
 Image* generate_entropy_histogram(const Args* args, ByteArray* bytes);
+Image* generate_sliding_entropy(const Args* args, ByteArray* bytes);
 Image* generate_histogram(const Args* args, ByteArray* bytes);
 Image* generate_bigrams(const Args* args, ByteArray* bytes);
 Image* generate_dotplot(const Args* args, ByteArray* bytes);
+Image* generate_dotplot_density(const Args* args, ByteArray* bytes);
+Image* generate_dotplot_kgram(const Args* args, ByteArray* bytes);
+
+/*
+ * Pointer to a function that fills the rows of an already initialized 'Image'
+ * from the specified 'ByteArray', whose first byte corresponds to the first
+ * pixel of the image. Each pixel aggregates 'samples_per_pixel' consecutive
+ * bytes, and the image must have enough rows for all of them.
+ *
+ * Unlike the generation functions above, these don't validate the program
+ * arguments.
+ */
+typedef bool (*generation_rows_func_ptr_t)(const Args* args,
+                                           const ByteArray* bytes,
+                                           size_t samples_per_pixel,
+                                           Image* image);
+
+/*
+ * Fill the rows of an 'Image' for the modes whose rows only depend on their own
+ * input bytes, which allows processing the input in consecutive chunks of rows.
+ * For the "entropy" mode, the bytes should start on a block boundary.
+ *
+ * When downsampling, the "grayscale" mode uses the mean of the samples of each
+ * pixel, the "ascii" mode uses the most common class, and the "entropy" mode
+ * uses the maximum entropy of the blocks that overlap the pixel.
+ */
+bool generate_grayscale_rows(const Args* args,
+                             const ByteArray* bytes,
+                             size_t samples_per_pixel,
+                             Image* image);
+bool generate_ascii_rows(const Args* args,
+                         const ByteArray* bytes,
+                         size_t samples_per_pixel,
+                         Image* image);
+bool generate_entropy_rows(const Args* args,
+                           const ByteArray* bytes,
+                           size_t samples_per_pixel,
+                           Image* image);
+
+/*
+ * Get the intensity, in the [00..FF] range, used for representing the
+ * specified entropy, in the [0..8] range, in the entropy-based modes. It's also
+ * the index of the corresponding color in the palette of their images.
+ */
+uint8_t generate_entropy_intensity(double entropy);
+
+/*
+ * Pointer to a function that initializes an 'Image' with the pixel format and
+ * palette expected by a row generation function.
+ */
+typedef bool (*generation_image_init_func_ptr_t)(Image* image,
+                                                 size_t width,
+                                                 size_t height);
+
+/*
+ * Initialize an 'Image' for the row generation functions above. Since the
+ * palette doesn't depend on the generated pixels, it can be used for exporting
+ * the rows before all of them are generated.
+ */
+bool generate_grayscale_image_init(Image* image, size_t width, size_t height);
+bool generate_ascii_image_init(Image* image, size_t width, size_t height);
+bool generate_entropy_image_init(Image* image, size_t width, size_t height);
 
 /*----------------------------------------------------------------------------*/
 
+/*
+ * Get the intensity, in the [0..255] range, used for representing a positive
+ * value relative to the maximum value, using the specified scale. Since the
+ * logarithmic scale is based on 'log(1+x)', the values should be counters of
+ * similar magnitude.
+ */
+static inline uint8_t generate_scaled_intensity(enum EArgsScale scale,
+                                                double value,
+                                                double max_value) {
+    if (value <= 0.0 || max_value <= 0.0)
+        return 0x00;
+    if (value >= max_value)
+        return 0xFF;
+
+    switch (scale) {
+        case ARGS_SCALE_LINEAR:
+            return value * 0xFF / max_value;
+        case ARGS_SCALE_LOG:
+            return log1p(value) * 0xFF / log1p(max_value);
+    }
+    return 0x00;
+}
+
+/*
+ * Get the number of input samples that should be aggregated into each pixel by
+ * the row generation functions, so the image of an input with the specified
+ * size doesn't exceed the maximum dimensions in the program arguments.
+ */
+static inline size_t generate_samples_per_pixel(const Args* args,
+                                                size_t input_size) {
+    const size_t width = args->output_width;
+
+    /* Maximum number of rows allowed by both limits, or zero if unlimited */
+    size_t max_rows = args->max_height;
+    if (args->max_pixels != 0) {
+        size_t rows = args->max_pixels / width;
+        if (rows == 0)
+            rows = 1;
+        if (max_rows == 0 || rows < max_rows)
+            max_rows = rows;
+    }
+    if (max_rows == 0)
+        return 1;
+
+    /* Smallest number of samples that fits the input in 'max_rows' rows */
+    const size_t max_samples = width * max_rows;
+    const size_t result      = (input_size + max_samples - 1) / max_samples;
+    return (result > 1) ? result : 1;
+}
+
 /*
  * Return a pointer to the generation function associated to a specific mode.
  */
@@ -63,14 +179,57 @@ static inline generation_func_ptr_t generation_func_from_mode(
             return generate_entropy;
         case ARGS_MODE_ENTROPY_HISTOGRAM:
             return generate_entropy_histogram;
+        case ARGS_MODE_SLIDING_ENTROPY:
+            return generate_sliding_entropy;
         case ARGS_MODE_HISTOGRAM:
             return generate_histogram;
         case ARGS_MODE_BIGRAMS:
             return generate_bigrams;
         case ARGS_MODE_DOTPLOT:
             return generate_dotplot;
+        case ARGS_MODE_DOTPLOT_DENSITY:
+            return generate_dotplot_density;
+        case ARGS_MODE_DOTPLOT_KGRAM:
+            return generate_dotplot_kgram;
     }
     return NULL;
 }
 
+/*
+ * Return a pointer to the row generation function associated to a specific
+ * mode, or NULL if the mode doesn't support generating rows independently.
+ */
+static inline generation_rows_func_ptr_t generation_rows_func_from_mode(
+  enum EArgsMode mode) {
+    switch (mode) {
+        case ARGS_MODE_GRAYSCALE:
+            return generate_grayscale_rows;
+        case ARGS_MODE_ASCII:
+            return generate_ascii_rows;
+        case ARGS_MODE_ENTROPY:
+            return generate_entropy_rows;
+        default:
+            return NULL;
+    }
+}
+
+/*
+ * Return a pointer to the image initialization function associated to the row
+ * generation function of a specific mode, or NULL if the mode doesn't support
+ * generating rows independently.
+ */
+static inline generation_image_init_func_ptr_t
+generation_image_init_func_from_mode(enum EArgsMode mode) {
+    switch (mode) {
+        case ARGS_MODE_GRAYSCALE:
+            return generate_grayscale_image_init;
+        case ARGS_MODE_ASCII:
+            return generate_ascii_image_init;
+        case ARGS_MODE_ENTROPY:
+            return generate_entropy_image_init;
+        default:
+            return NULL;
+    }
+}
+
 #endif /* GENERATE_H_ */
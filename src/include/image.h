@@ -25,26 +25,155 @@
 
 #include "args.h" /* Args */
 
+/*
+ * Maximum number of colors in an 'ImagePalette', and number of slots of its
+ * hash table, which must be a power of two.
+ */
+#define IMAGE_PALETTE_MAX_SIZE  256
+#define IMAGE_PALETTE_HASH_SIZE 512
+
+/*
+ * Minimum size in bytes of the pixel array of an image for storing it in a
+ * temporary file mapped into memory, instead of the heap. This allows the
+ * kernel to write the pixels back to disk when the image doesn't fit in RAM.
+ */
+#ifndef IMAGE_MAPPED_MIN_SIZE
+#define IMAGE_MAPPED_MIN_SIZE ((size_t)1 << 30)
+#endif /* IMAGE_MAPPED_MIN_SIZE */
+
 typedef struct Color {
     uint8_t r, g, b;
 } Color;
 
+/*
+ * List of different colors used by an image, along with a hash table for
+ * finding the index of a color in constant time.
+ */
+typedef struct ImagePalette {
+    Color colors[IMAGE_PALETTE_MAX_SIZE];
+    size_t size;
+
+    /* Index in the 'colors' array for each slot, or -1 if the slot is empty */
+    int16_t slots[IMAGE_PALETTE_HASH_SIZE];
+} ImagePalette;
+
+/*
+ * Layout of the pixels of an 'Image'. Generation modes should use the
+ * narrowest format that can represent their output.
+ */
+enum EImageFormat {
+    IMAGE_FORMAT_RGB24,    /* One 'Color' structure per pixel */
+    IMAGE_FORMAT_GRAY8,    /* One intensity byte per pixel */
+    IMAGE_FORMAT_INDEXED8, /* One byte per pixel, index in the image palette */
+};
+
 typedef struct Image {
-    Color* pixels;        /* RGB */
+    enum EImageFormat format;
+    uint8_t* data;        /* Pixels, see 'EImageFormat' */
     size_t width, height; /* In pixels, not bytes */
+
+    /*
+     * Colors of each index in 'IMAGE_FORMAT_INDEXED8' images. The first color
+     * should be black, since index zero is used for padding.
+     */
+    ImagePalette palette;
+
+    /*
+     * If not zero, the 'data' array is a mapping of a temporary file, of
+     * 'mapping_size' bytes, instead of a heap buffer. See
+     * 'IMAGE_MAPPED_MIN_SIZE'.
+     */
+    size_t mapping_size;
 } Image;
 
 /*----------------------------------------------------------------------------*/
 
 /*
- * Initialize an 'Image' structure. The caller is responsible of deinitializing
- * the image with 'image_deinit'.
+ * Check if two colors are equal.
  */
-bool image_init(Image* image, size_t width, size_t height);
+static inline bool colors_equal(Color a, Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
 
 /*
- * Free all members of an Image structure. Doesn't free the Image itself.
+ * Size in bytes of each pixel of the specified format.
+ */
+static inline size_t image_pixel_size(enum EImageFormat format) {
+    return (format == IMAGE_FORMAT_RGB24) ? sizeof(Color) : 1;
+}
+
+/*
+ * Get the color of the pixel at the specified index, regardless of the format
+ * of the image.
+ */
+static inline Color image_get_color(const Image* image, size_t i) {
+    switch (image->format) {
+        case IMAGE_FORMAT_GRAY8:
+            return (Color){ image->data[i], image->data[i], image->data[i] };
+        case IMAGE_FORMAT_INDEXED8:
+            return image->palette.colors[image->data[i]];
+        case IMAGE_FORMAT_RGB24:
+        default:
+            return ((const Color*)image->data)[i];
+    }
+}
+
+/*
+ * Initialize an 'Image' structure with the specified pixel format. All pixels
+ * are initialized to zero, and the palette is left empty. The caller is
+ * responsible of deinitializing the image with 'image_deinit'.
+ *
+ * Pixel arrays of at least 'IMAGE_MAPPED_MIN_SIZE' bytes are stored in a
+ * temporary file, which is transparent to the users of the image.
+ */
+bool image_init(Image* image,
+                enum EImageFormat format,
+                size_t width,
+                size_t height);
+
+/*
+ * Convert the pixels of an image to the 'IMAGE_FORMAT_RGB24' format. Returns
+ * true on success, or false otherwise, in which case the image is left
+ * untouched.
+ */
+bool image_convert_to_rgb(Image* image);
+
+/*
+ * Append the rows of the 'src' image below the rows of the 'dst' image,
+ * resizing 'dst' as needed. If the widths don't match, the narrower image is
+ * padded with black pixels on the right. If the formats or palettes don't
+ * match, 'dst' is converted to 'IMAGE_FORMAT_RGB24'. Returns true on success,
+ * or false otherwise.
+ */
+bool image_append(Image* dst, const Image* src);
+
+/*
+ * Free or unmap all members of an Image structure. Doesn't free the Image
+ * itself.
  */
 void image_deinit(Image* image);
 
+/*
+ * Initialize an empty 'ImagePalette'.
+ */
+void image_palette_init(ImagePalette* palette);
+
+/*
+ * Get the index of the specified color in an 'ImagePalette', or -1 if it's not
+ * in the palette.
+ */
+int image_palette_find(const ImagePalette* palette, Color color);
+
+/*
+ * Add a color to an 'ImagePalette', unless it's already in it. Returns false if
+ * the palette is full and the color couldn't be added, or true otherwise.
+ */
+bool image_palette_add(ImagePalette* palette, Color color);
+
+/*
+ * Initialize an 'ImagePalette' with the colors used by the specified image.
+ * Returns false if the image has more than 'IMAGE_PALETTE_MAX_SIZE' colors.
+ */
+bool image_get_palette(const Image* image, ImagePalette* palette);
+
 #endif /* IMAGE_H_ */
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LAYOUT_H_
+#define LAYOUT_H_ 1
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "args.h"  /* Args */
+#include "image.h" /* Image */
+
+/*
+ * Spatial layout of the pixels of a linear image, that is, the position of each
+ * pixel in the transformed image.
+ *
+ * All the supported transformations are periodic: the pixels of each group of
+ * 'period' consecutive pixels are moved to a group of 'period' consecutive
+ * pixels of the transformed image, in the same order as the groups. Inside each
+ * period, the pixels are moved in runs of 'run' consecutive pixels, so the
+ * layout only needs the position of each run.
+ *
+ * Since the period is a multiple of the transformed width, each period can be
+ * transformed as soon as it's generated, without the whole image. A chain of
+ * transformations is also periodic, with the least common multiple of their
+ * periods, so it's described by a single layout.
+ *
+ * The offsets only depend on the transformations and the width of the image,
+ * so they can be stored in a cache directory and mapped into memory on later
+ * runs. See 'Args.layout_cache_dir'.
+ */
+typedef struct Layout {
+    /* Dimensions of the transformed image */
+    size_t width, height;
+
+    /* Number of pixels in each period, and in each run */
+    size_t period, run;
+
+    /*
+     * Position of the first pixel of each run in the transformed image,
+     * relative to the start of its period. If NULL, the pixels are not moved.
+     */
+    uint32_t* offsets;
+
+    /*
+     * If not NULL, the 'offsets' array is part of a read-only mapping of a
+     * cache file, of 'mapping_size' bytes, instead of a heap buffer.
+     */
+    void* mapping;
+    size_t mapping_size;
+} Layout;
+
+/*
+ * Initialize the layout of the chain of transformations in the specified
+ * arguments, for a linear image of the specified dimensions. If there are no
+ * transformations, the pixels are not moved. If a cache directory was
+ * specified, the offsets are read from it, or stored in it if they were not
+ * cached. Returns false if a transformation can't be applied to an image of
+ * this size, or on allocation errors.
+ */
+bool layout_init(Layout* layout,
+                 const Args* args,
+                 size_t width,
+                 size_t height);
+
+/*
+ * Check if the transformations in the specified arguments can be applied to an
+ * image of the specified width, without building their layout. If they can,
+ * and 'period' is not NULL, the period of the layout is stored in it.
+ */
+bool layout_is_supported(const Args* args, size_t width, size_t* period);
+
+/*
+ * Free or unmap the members of a 'Layout' structure. Doesn't free the 'Layout'
+ * itself.
+ */
+void layout_deinit(Layout* layout);
+
+/*
+ * Move the first 'src_pixels' pixels of 'src', which must start on a period
+ * boundary, to their position in 'dst', which contains the rows of the
+ * transformed image for those periods. The remaining pixels of 'dst' are
+ * filled with zeros. Both images must have the same pixel format.
+ */
+void layout_apply(const Args* args,
+                  const Layout* layout,
+                  const Image* src,
+                  size_t src_pixels,
+                  Image* dst);
+
+/*
+ * Move all the pixels of an image to their position in the specified layout,
+ * which must have been initialized for the dimensions of the image. The
+ * dimensions of the image are updated. Returns true on success, or false
+ * otherwise, in which case the image is left untouched.
+ */
+bool layout_apply_to_image(const Args* args,
+                           const Layout* layout,
+                           Image* image);
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Check if the specified layout moves any pixel.
+ */
+static inline bool layout_is_identity(const Layout* layout) {
+    return layout->offsets == NULL;
+}
+
+#endif /* LAYOUT_H_ */
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARALLEL_H_
+#define PARALLEL_H_ 1
+
+#include <stddef.h>
+
+/*
+ * Pointer to a function that processes the items in the [start..end) range.
+ * The 'job' argument is the index of the range, in the [0..jobs) range, which
+ * can be used for accessing per-thread data.
+ */
+typedef void (*parallel_func_ptr_t)(void* data,
+                                    size_t job,
+                                    size_t start,
+                                    size_t end);
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Get the number of jobs that 'parallel_for' will actually use for the
+ * specified number of items. If 'jobs' is zero, the number of online
+ * processors is used.
+ */
+size_t parallel_get_jobs(size_t jobs, size_t num_items);
+
+/*
+ * Split the [0..num_items) range into contiguous ranges of similar size, and
+ * call 'func' on each of them from a different thread, waiting for all of them
+ * to finish. See 'parallel_get_jobs' for the meaning of 'jobs'.
+ *
+ * The threads are kept in a pool that is reused across calls, so the function
+ * can be called often with small ranges. Calls made while the pool is busy,
+ * like the ones made from 'func', create their own threads instead.
+ *
+ * The calling thread also processes one of the ranges, and if a thread can't be
+ * created, its range is processed by the calling thread too, so the function
+ * never fails.
+ */
+void parallel_for(size_t jobs,
+                  size_t num_items,
+                  parallel_func_ptr_t func,
+                  void* data);
+
+#endif /* PARALLEL_H_ */
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef STREAM_H_
+#define STREAM_H_ 1
+
+#include <stdbool.h>
+#include <stdio.h> /* FILE */
+
+#include "args.h"
+
+/*
+ * Minimum number of input bytes processed in each chunk when streaming. The
+ * actual size is rounded up to a multiple of the row size (or the period of the
+ * layout, when transforming) and, if needed, of the block size, and limited to
+ * the size of the input.
+ */
+#ifndef STREAM_CHUNK_SIZE
+#define STREAM_CHUNK_SIZE 0x100000
+#endif /* STREAM_CHUNK_SIZE */
+
+/*
+ * Maximum number of input bytes in each chunk, when aligning multiple periods
+ * to the block size. Bigger chunks are not streamed.
+ */
+#ifndef STREAM_MAX_CHUNK_SIZE
+#define STREAM_MAX_CHUNK_SIZE (16 * STREAM_CHUNK_SIZE)
+#endif /* STREAM_MAX_CHUNK_SIZE */
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Check if the image for the specified arguments can be generated and exported
+ * in consecutive chunks of rows, instead of reading the whole input and
+ * generating the whole image in memory.
+ *
+ * This is only possible for a single region of an input with a known size, for
+ * modes whose rows only depend on their own bytes, and for output formats that
+ * can be written row by row. Transformations are applied to each chunk through
+ * their 'Layout'.
+ */
+bool stream_is_supported(const Args* args, FILE* input_fp);
+
+/*
+ * Read the input, generate the image and export it in consecutive chunks of
+ * rows, so the memory usage only depends on the size of each chunk, not on the
+ * size of the input. The caller should check 'stream_is_supported' first. This
+ * function returns true on success, or false otherwise.
+ */
+bool stream_image(const Args* args, FILE* input_fp, FILE* output_fp);
+
+#endif /* STREAM_H_ */
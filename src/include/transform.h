@@ -20,9 +20,11 @@
 #define TRANSFORM_H_ 1
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "image.h"
 #include "args.h"
+#include "layout.h"
 
 /*
  * Pointer to a function that transforms an 'Image' depending on the program
@@ -30,23 +32,58 @@
  */
 typedef bool (*transformation_func_ptr_t)(const Args* args, Image* image);
 
+/*
+ * Pointer to a function that sets the dimensions, period and run of the layout
+ * of a transformation, from the dimensions of the linear image stored in it.
+ * Returns false if the transformation can't be applied to an image of that
+ * width. See 'Layout'.
+ */
+typedef bool (*transformation_geometry_func_ptr_t)(Layout* layout,
+                                                   size_t param);
+
+/*
+ * Pointer to a function that fills the allocated offsets of a layout, whose
+ * geometry was set by the corresponding 'transformation_geometry_func_ptr_t'.
+ */
+typedef void (*transformation_offsets_func_ptr_t)(const Args* args,
+                                                  Layout* layout,
+                                                  size_t param);
+
+/*
+ * Apply all the transformations in the program arguments, in order, moving each
+ * pixel of the image only once.
+ */
+bool transform_image(const Args* args, Image* image);
+
 /*
  * Group the data of a linear image into squares of side N. If the image
  * dimensions are not divisible by N, they will be increased.
  */
-bool transform_squares(const Args* args, Image* image);
+bool transform_squares_geometry(Layout* layout, size_t side);
+void transform_squares_offsets(const Args* args, Layout* layout, size_t side);
 
 /*
  * Transform the image in a linear image into a ZigZag pattern, reversing odd
  * rows.
  */
-bool transform_zigzag(const Args* args, Image* image);
+bool transform_zigzag_geometry(Layout* layout, size_t param);
+void transform_zigzag_offsets(const Args* args, Layout* layout, size_t param);
 
 /*
- * Transform the specified input string into an output grid buffer using a
- * space-filling Hilbert curve, with the specified recursion level.
+ * Place the pixels of a linear image along space-filling Hilbert curves, with
+ * the specified recursion level. Each curve fills a square of the width of the
+ * image, and the squares are stacked vertically.
  */
-bool transform_hilbert(const Args* args, Image* image);
+bool transform_hilbert_geometry(Layout* layout, size_t level);
+void transform_hilbert_offsets(const Args* args, Layout* layout, size_t level);
+
+/*
+ * Place the pixels of a linear image along Z-order (Morton) curves, with the
+ * specified recursion level. The curves are placed like in the Hilbert
+ * transformation, but each position is obtained by interleaving the bits of its
+ * coordinates, which is much cheaper for huge images.
+ */
+void transform_morton_offsets(const Args* args, Layout* layout, size_t level);
 
 /*----------------------------------------------------------------------------*/
 
@@ -56,12 +93,41 @@ bool transform_hilbert(const Args* args, Image* image);
  */
 static inline transformation_func_ptr_t transformation_func_from_args(
   const Args* args) {
-    if (args->transform_squares_side > 1)
-        return transform_squares;
-    if (args->transform_zigzag)
-        return transform_zigzag;
-    if (args->transform_hilbert_level >= 1)
-        return transform_hilbert;
+    return (args->transforms_num > 0) ? transform_image : NULL;
+}
+
+/*
+ * Return a pointer to the geometry function of the specified transformation.
+ */
+static inline transformation_geometry_func_ptr_t
+transformation_geometry_func_from_type(enum EArgsTransform type) {
+    switch (type) {
+        case ARGS_TRANSFORM_SQUARES:
+            return transform_squares_geometry;
+        case ARGS_TRANSFORM_ZIGZAG:
+            return transform_zigzag_geometry;
+        case ARGS_TRANSFORM_HILBERT:
+        case ARGS_TRANSFORM_MORTON:
+            return transform_hilbert_geometry;
+    }
+    return NULL;
+}
+
+/*
+ * Return a pointer to the offsets function of the specified transformation.
+ */
+static inline transformation_offsets_func_ptr_t
+transformation_offsets_func_from_type(enum EArgsTransform type) {
+    switch (type) {
+        case ARGS_TRANSFORM_SQUARES:
+            return transform_squares_offsets;
+        case ARGS_TRANSFORM_ZIGZAG:
+            return transform_zigzag_offsets;
+        case ARGS_TRANSFORM_HILBERT:
+            return transform_hilbert_offsets;
+        case ARGS_TRANSFORM_MORTON:
+            return transform_morton_offsets;
+    }
     return NULL;
 }
 
@@ -25,15 +25,6 @@
 
 #include "image.h" /* Color */
 
-/*
- * Maximum value returned by a function that calculates the entropy of an array
- * of bytes using a base 2 logarithm. For more information, see:
- * https://8dcc.github.io/programming/understanding-entropy.html#entropy-range
- */
-#define MAX_ENTROPY 8.0
-
-/*----------------------------------------------------------------------------*/
-
 /*
  * Mark a symbol as unused in the current scope.
  */
@@ -78,18 +69,8 @@
 /*----------------------------------------------------------------------------*/
 
 /*
- * Calculate the Shannon entropy of the specified bytes. Since log2() is used,
- * the return value is in the [0..8] range.
- *
- * For more information, see my article about entropy:
- * https://8dcc.github.io/programming/understanding-entropy.html
- */
-double entropy(void* data, size_t data_sz);
-
-/*
- * Reverse a buffer in-place, with the specified number of elements of the
- * specified size each. Returns the 'buf' argument on success, or NULL on error.
+ * Greatest common divisor of two numbers, using the Euclidean algorithm.
  */
-void* reverse_buffer(void* buf, size_t num_elems, size_t elem_sz);
+size_t gcd(size_t a, size_t b);
 
 #endif /* UTIL_H_ */
@@ -0,0 +1,559 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "include/layout.h"
+#include "include/args.h"
+#include "include/file.h"
+#include "include/image.h"
+#include "include/parallel.h"
+#include "include/transform.h"
+#include "include/util.h"
+
+/*
+ * Identifier at the start of each layout cache file. The last characters are
+ * the version of the file format.
+ */
+#define LAYOUT_CACHE_MAGIC "BGLAYT01"
+
+/*
+ * Header of the layout cache files, followed by the offsets. The offsets are
+ * stored in the byte order of the machine that wrote them, which is checked
+ * with 'byte_order'.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t reserved;
+    uint64_t width, period, run;
+} LayoutCacheHeader;
+
+/*
+ * Data shared by all the threads of 'layout_apply'.
+ */
+typedef struct {
+    const Layout* layout;
+    const Image* src;
+    size_t src_pixels;
+    Image* dst;
+} LayoutJobData;
+
+/*
+ * Data shared by all the threads that compose the offsets of a chain of
+ * transformations.
+ */
+typedef struct {
+    const Layout* stages;
+    size_t stages_num;
+    uint32_t* offsets;
+} ComposeJobData;
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Set the geometry of each transformation in the arguments, in 'stages', using
+ * the dimensions of each stage as the linear image of the next one. The final
+ * dimensions and the period of the whole chain are stored in 'layout', whose
+ * dimensions must be initialized. Returns false if a transformation can't be
+ * applied, printing the reason if 'verbose' is true.
+ */
+static bool chain_geometry(const Args* args,
+                           Layout* layout,
+                           Layout* stages,
+                           bool verbose) {
+    /*
+     * Each stage keeps the pixels inside its own periods, so the chain keeps
+     * them inside periods of the least common multiple of all the periods.
+     */
+    size_t period = 1;
+    for (size_t i = 0; i < args->transforms_num; i++) {
+        const ArgsTransform* transform = &args->transforms[i];
+        const char* name = args_get_transform_name(transform->type);
+
+        Layout* stage       = &stages[i];
+        stage->width        = layout->width;
+        stage->height       = layout->height;
+        stage->offsets      = NULL;
+        stage->mapping      = NULL;
+        stage->mapping_size = 0;
+
+        transformation_geometry_func_ptr_t geometry_func =
+          transformation_geometry_func_from_type(transform->type);
+        if (!geometry_func(stage, transform->param)) {
+            if (verbose)
+                ERR("The \"%s\" transformation can't be applied to an image "
+                    "of width %zu.",
+                    name,
+                    layout->width);
+            return false;
+        }
+
+        /* The offsets are relative to their period, so they are 32-bit */
+        const size_t max_period = (size_t)UINT32_MAX + 1;
+        const size_t factor     = stage->period / gcd(period, stage->period);
+        if (stage->period > max_period || factor > max_period / period) {
+            if (verbose)
+                ERR("The layout period of the \"%s\" transformation is too "
+                    "big.",
+                    name);
+            return false;
+        }
+
+        period *= factor;
+        layout->width  = stage->width;
+        layout->height = stage->height;
+    }
+
+    layout->period = period;
+    layout->run    = 1;
+    return true;
+}
+
+/*
+ * Allocate and fill the offsets of a layout with the geometry of the specified
+ * transformation. Returns true on success, or false otherwise.
+ */
+static bool fill_offsets(const Args* args,
+                         const ArgsTransform* transform,
+                         Layout* layout) {
+    layout->offsets = malloc(layout->period / layout->run * sizeof(uint32_t));
+    if (layout->offsets == NULL)
+        return false;
+
+    transformation_offsets_func_ptr_t offsets_func =
+      transformation_offsets_func_from_type(transform->type);
+    offsets_func(args, layout, transform->param);
+    return true;
+}
+
+/*
+ * Calculate the position of each pixel in the [start..end) range of a period,
+ * after moving it through all the stages of the chain.
+ */
+static void compose_job(void* data, size_t job, size_t start, size_t end) {
+    UNUSED(job);
+
+    const ComposeJobData* ctx = data;
+    for (size_t i = start; i < end; i++) {
+        size_t pos = i;
+        for (size_t j = 0; j < ctx->stages_num; j++) {
+            const Layout* stage     = &ctx->stages[j];
+            const size_t in_period  = pos % stage->period;
+            const size_t period_pos = pos - in_period;
+            pos = period_pos + stage->offsets[in_period / stage->run] +
+                  in_period % stage->run;
+        }
+        ctx->offsets[i] = pos;
+    }
+}
+
+/*
+ * Merge the offsets of a layout with single-pixel runs into the longest runs
+ * whose pixels are still consecutive in the transformed image, that is, the
+ * greatest common divisor of the positions where they stop being consecutive.
+ * If the whole period is consecutive, the layout doesn't move any pixel.
+ */
+static void merge_runs(Layout* layout) {
+    assert(layout->run == 1);
+
+    size_t run = layout->period;
+    for (size_t i = 1; i < layout->period && run > 1; i++)
+        if (layout->offsets[i] != layout->offsets[i - 1] + 1)
+            run = gcd(run, i);
+
+    if (run == layout->period && layout->offsets[0] == 0) {
+        free(layout->offsets);
+        layout->offsets = NULL;
+        layout->period  = layout->width;
+        layout->run     = layout->width;
+        return;
+    }
+
+    if (run == 1)
+        return;
+
+    const size_t runs_num = layout->period / run;
+    for (size_t i = 0; i < runs_num; i++)
+        layout->offsets[i] = layout->offsets[i * run];
+    layout->run = run;
+
+    /* Failing to shrink the array is not an error */
+    uint32_t* shrunk = realloc(layout->offsets, runs_num * sizeof(uint32_t));
+    if (shrunk != NULL)
+        layout->offsets = shrunk;
+}
+
+/*
+ * Fill the offsets of a layout for the chain of transformations in the
+ * arguments, whose geometry was set by 'chain_geometry'. Each pixel is moved
+ * through all the stages, so the layout moves each pixel only once. Returns
+ * true on success, or false otherwise.
+ */
+static bool chain_offsets(const Args* args, Layout* layout, Layout* stages) {
+    if (args->transforms_num == 1) {
+        layout->run = stages[0].run;
+        return fill_offsets(args, &args->transforms[0], layout);
+    }
+
+    bool result = true;
+    for (size_t i = 0; i < args->transforms_num && result; i++)
+        result = fill_offsets(args, &args->transforms[i], &stages[i]);
+
+    if (result) {
+        layout->offsets = malloc(layout->period * sizeof(uint32_t));
+        result          = (layout->offsets != NULL);
+    }
+
+    if (result) {
+        ComposeJobData data = {
+            .stages     = stages,
+            .stages_num = args->transforms_num,
+            .offsets    = layout->offsets,
+        };
+        parallel_for(args->jobs, layout->period, compose_job, &data);
+        merge_runs(layout);
+    }
+
+    for (size_t i = 0; i < args->transforms_num; i++)
+        free(stages[i].offsets);
+    return result;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Write the path of the cache file of the layout of the transformations in the
+ * arguments, for a linear image of the specified width, to 'dst', of
+ * 'dst_size' bytes. Returns false if it doesn't fit.
+ */
+static bool cache_path(char* dst,
+                       size_t dst_size,
+                       const Args* args,
+                       size_t width) {
+    size_t len = snprintf(dst, dst_size, "%s/", args->layout_cache_dir);
+    for (size_t i = 0; i < args->transforms_num && len < dst_size; i++) {
+        const ArgsTransform* transform = &args->transforms[i];
+        len += snprintf(&dst[len],
+                        dst_size - len,
+                        "%s%s-%zu",
+                        (i == 0) ? "" : "_",
+                        args_get_transform_name(transform->type),
+                        transform->param);
+    }
+    if (len < dst_size)
+        len += snprintf(&dst[len], dst_size - len, "-%zu.layout", width);
+    return len < dst_size;
+}
+
+/*
+ * Fill the header of the cache file of a layout.
+ */
+static void cache_header(LayoutCacheHeader* header, const Layout* layout) {
+    memset(header, 0, sizeof(LayoutCacheHeader));
+    memcpy(header->magic, LAYOUT_CACHE_MAGIC, sizeof(header->magic));
+    header->byte_order = 0x01020304;
+    header->width      = layout->width;
+    header->period     = layout->period;
+    header->run        = layout->run;
+}
+
+/*
+ * Check that each run of the specified offsets is inside its period, and that
+ * runs that are not longer than a row don't cross the end of a row. Since the
+ * cache files can be modified, this is checked before moving any pixel.
+ */
+static bool cache_offsets_are_valid(const Layout* layout,
+                                    const uint32_t* offsets,
+                                    size_t run) {
+    const size_t runs_num = layout->period / run;
+    for (size_t i = 0; i < runs_num; i++) {
+        if (offsets[i] > layout->period - run)
+            return false;
+        if (run <= layout->width &&
+            offsets[i] % layout->width + run > layout->width)
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Map the offsets of a layout with a valid geometry from its cache file. The
+ * run of the layout is read from the file, since the runs of a chain are only
+ * known after composing its offsets. Returns false if the file doesn't exist,
+ * doesn't match the layout or contains invalid offsets, in which case the
+ * layout is not modified.
+ */
+static bool cache_load(Layout* layout, const char* path) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    LayoutCacheHeader header;
+    struct stat st;
+    size_t file_size = 0;
+    if (read(fd, &header, sizeof(header)) == sizeof(header) &&
+        header.run > 0 && header.run <= layout->period &&
+        layout->period % header.run == 0 && fstat(fd, &st) == 0 &&
+        S_ISREG(st.st_mode))
+        file_size = sizeof(LayoutCacheHeader) +
+                    layout->period / header.run * sizeof(uint32_t);
+
+    LayoutCacheHeader expected;
+    cache_header(&expected, layout);
+    expected.run = header.run;
+
+    void* mapping = MAP_FAILED;
+    if (file_size != 0 && (size_t)st.st_size == file_size &&
+        memcmp(&header, &expected, sizeof(LayoutCacheHeader)) == 0)
+        mapping = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    uint32_t* offsets = NULL;
+    if (mapping != MAP_FAILED) {
+        offsets = (uint32_t*)((uint8_t*)mapping + sizeof(LayoutCacheHeader));
+        if (!cache_offsets_are_valid(layout, offsets, header.run)) {
+            munmap(mapping, file_size);
+            mapping = MAP_FAILED;
+        }
+    }
+
+    if (mapping == MAP_FAILED) {
+        WRN("Ignoring invalid layout cache file '%s'.", path);
+        return false;
+    }
+
+    layout->run          = header.run;
+    layout->offsets      = offsets;
+    layout->mapping      = mapping;
+    layout->mapping_size = file_size;
+    return true;
+}
+
+/*
+ * Store the offsets of a layout in its cache file. The file is written with a
+ * temporary name and renamed, so concurrent runs never read a partial file.
+ * Returns true on success, or false otherwise.
+ */
+static bool cache_store(const Layout* layout,
+                        const char* dir,
+                        const char* path) {
+    if (!file_make_dir(dir))
+        return false;
+
+    char tmp_path[FILENAME_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path) >=
+        (int)sizeof(tmp_path))
+        return false;
+
+    const int fd = mkstemp(tmp_path);
+    if (fd < 0)
+        return false;
+
+    FILE* fp = fdopen(fd, "wb");
+    if (fp == NULL) {
+        close(fd);
+        unlink(tmp_path);
+        return false;
+    }
+
+    LayoutCacheHeader header;
+    cache_header(&header, layout);
+    const size_t offsets_num = layout->period / layout->run;
+    bool result =
+      fwrite(&header, sizeof(header), 1, fp) == 1 &&
+      fwrite(layout->offsets, sizeof(uint32_t), offsets_num, fp) ==
+        offsets_num;
+    result = (fclose(fp) == 0) && result;
+
+    /* Cache files are read-only, like the mapping */
+    result = result && chmod(tmp_path, 0444) == 0 &&
+             rename(tmp_path, path) == 0;
+    if (!result)
+        unlink(tmp_path);
+    return result;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Move the runs in the [start..end) range, counting the runs of all the
+ * periods in the source image.
+ */
+static void layout_job(void* data, size_t job, size_t start, size_t end) {
+    UNUSED(job);
+
+    const LayoutJobData* ctx = data;
+    const Layout* layout     = ctx->layout;
+    const size_t pixel_size  = image_pixel_size(ctx->src->format);
+    const size_t run         = layout->run;
+    const size_t runs_num    = layout->period / run;
+    const uint8_t* src       = ctx->src->data;
+    uint8_t* dst             = ctx->dst->data;
+
+    size_t period     = start / runs_num;
+    size_t period_run = start % runs_num;
+    for (size_t i = start; i < end; i++) {
+        const size_t src_pos = run * i;
+        const size_t dst_pos =
+          layout->period * period + layout->offsets[period_run];
+
+        /* The last run might be incomplete */
+        const size_t copied = (ctx->src_pixels - src_pos < run)
+                                ? ctx->src_pixels - src_pos
+                                : run;
+        assert(dst_pos + copied <= ctx->dst->width * ctx->dst->height);
+
+        if (run == 1 && pixel_size == 1)
+            dst[dst_pos] = src[src_pos];
+        else
+            memcpy(&dst[dst_pos * pixel_size],
+                   &src[src_pos * pixel_size],
+                   copied * pixel_size);
+
+        if (++period_run == runs_num) {
+            period_run = 0;
+            period++;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+bool layout_init(Layout* layout,
+                 const Args* args,
+                 size_t width,
+                 size_t height) {
+    layout->width        = width;
+    layout->height       = height;
+    layout->period       = width;
+    layout->run          = width;
+    layout->offsets      = NULL;
+    layout->mapping      = NULL;
+    layout->mapping_size = 0;
+
+    if (args->transforms_num == 0)
+        return true;
+
+    Layout stages[ARGS_MAX_TRANSFORMS];
+    if (!chain_geometry(args, layout, stages, true))
+        return false;
+
+    char path[FILENAME_MAX];
+    const bool use_cache = args->layout_cache_dir != NULL &&
+                           cache_path(path, sizeof(path), args, width);
+    if (use_cache && cache_load(layout, path))
+        return true;
+
+    if (!chain_offsets(args, layout, stages))
+        return false;
+
+    /* Chains that don't move any pixel are not cached */
+    if (use_cache && !layout_is_identity(layout) &&
+        !cache_store(layout, args->layout_cache_dir, path))
+        WRN("Failed to store the layout cache file '%s'.", path);
+
+    return true;
+}
+
+bool layout_is_supported(const Args* args, size_t width, size_t* period) {
+    Layout layout = {
+        .width  = width,
+        .height = 1,
+    };
+    Layout stages[ARGS_MAX_TRANSFORMS];
+    if (!chain_geometry(args, &layout, stages, false))
+        return false;
+
+    /* Without transformations, each row is a period, like in 'layout_init' */
+    if (period != NULL)
+        *period = (args->transforms_num == 0) ? width : layout.period;
+    return true;
+}
+
+void layout_deinit(Layout* layout) {
+    if (layout->mapping != NULL)
+        munmap(layout->mapping, layout->mapping_size);
+    else
+        free(layout->offsets);
+
+    layout->offsets      = NULL;
+    layout->mapping      = NULL;
+    layout->mapping_size = 0;
+}
+
+void layout_apply(const Args* args,
+                  const Layout* layout,
+                  const Image* src,
+                  size_t src_pixels,
+                  Image* dst) {
+    assert(src->format == dst->format);
+    assert(src_pixels <= src->width * src->height);
+
+    /* Pixels that don't receive any input pixel are filled with zeros */
+    const size_t dst_pixels = dst->width * dst->height;
+    if (src_pixels < dst_pixels)
+        memset(dst->data, 0, dst_pixels * image_pixel_size(dst->format));
+
+    if (layout_is_identity(layout)) {
+        memcpy(dst->data,
+               src->data,
+               src_pixels * image_pixel_size(src->format));
+        return;
+    }
+
+    LayoutJobData data = {
+        .layout     = layout,
+        .src        = src,
+        .src_pixels = src_pixels,
+        .dst        = dst,
+    };
+    const size_t runs_num = (src_pixels + layout->run - 1) / layout->run;
+    parallel_for(args->jobs, runs_num, layout_job, &data);
+}
+
+bool layout_apply_to_image(const Args* args,
+                           const Layout* layout,
+                           Image* image) {
+    Image new_image;
+    if (!image_init(&new_image, image->format, layout->width, layout->height))
+        return false;
+
+    layout_apply(args, layout, image, image->width * image->height, &new_image);
+
+    /* Free the old pixel array and overwrite the image with the new one */
+    new_image.palette = image->palette;
+    image_deinit(image);
+    *image = new_image;
+    return true;
+}
@@ -28,6 +28,7 @@
 #include "include/generate.h"
 #include "include/transform.h"
 #include "include/export.h"
+#include "include/stream.h"
 #include "include/util.h"
 
 int main(int argc, char** argv) {
@@ -40,12 +41,37 @@ int main(int argc, char** argv) {
     if (input_fp == NULL)
         DIE("Can't open file '%s': %s", args.input_filename, strerror(errno));
 
-    /* Read and store the file bytes in a 'ByteArray' */
-    ByteArray file_bytes;
-    if (!file_read(&file_bytes, input_fp, args.offset_start, args.offset_end))
+    /*
+     * If possible, generate and export the image in chunks, without storing
+     * the whole input or image in memory.
+     */
+    if (stream_is_supported(&args, input_fp)) {
+        FILE* output_fp = file_open(args.output_filename, FILE_MODE_WRITE);
+        if (output_fp == NULL)
+            DIE("Can't open file '%s': %s",
+                args.output_filename,
+                strerror(errno));
+
+        if (!stream_image(&args, input_fp, output_fp))
+            DIE("Failed to generate and export image.");
+
+        fclose(input_fp);
+        fclose(output_fp);
+        return 0;
+    }
+
+    /* Read and store the bytes of each region in a 'ByteArray' */
+    ByteArray regions_bytes[ARGS_MAX_REGIONS];
+    if (!file_read_regions(regions_bytes,
+                           input_fp,
+                           args.regions,
+                           args.regions_num))
         DIE("Error reading file '%s'.", args.input_filename);
-    if (file_bytes.size <= 0)
-        DIE("Received empty byte array after reading input file. Aborting.");
+    for (size_t i = 0; i < args.regions_num; i++)
+        if (regions_bytes[i].size <= 0)
+            DIE("Received empty byte array after reading region #%zu of the "
+                "input file. Aborting.",
+                i);
 
     fclose(input_fp);
 
@@ -54,19 +80,40 @@ int main(int argc, char** argv) {
       generation_func_from_mode(args.mode);
     assert(generation_func != NULL);
 
-    /* Convert the ByteArray to a color Image depending on the global mode */
-    Image* image = generation_func(&args, &file_bytes);
-    if (image == NULL)
-        DIE("Failed to generate image.");
-
-    /* We are done with the initial file bytes, free them */
-    byte_array_destroy(&file_bytes);
-
-    /* Optionally, perform different transformations to the generated image */
+    /* Obtain the optional transformation function from the program arguments */
     transformation_func_ptr_t transformation_func =
       transformation_func_from_args(&args);
-    if (transformation_func != NULL && !transformation_func(&args, image))
-        ERR("Failed to run transformation function. Ignoring...");
+
+    /*
+     * Generate an image for each region, and stack them vertically into the
+     * first one.
+     */
+    Image* image = NULL;
+    for (size_t i = 0; i < args.regions_num; i++) {
+        /* Convert the ByteArray to a color Image depending on the global mode */
+        Image* region_image = generation_func(&args, &regions_bytes[i]);
+        if (region_image == NULL)
+            DIE("Failed to generate image.");
+
+        /* We are done with the region bytes, free them */
+        byte_array_destroy(&regions_bytes[i]);
+
+        /* Optionally, perform different transformations to the image */
+        if (transformation_func != NULL &&
+            !transformation_func(&args, region_image))
+            ERR("Failed to run transformation function. Ignoring...");
+
+        if (image == NULL) {
+            image = region_image;
+            continue;
+        }
+
+        if (!image_append(image, region_image))
+            DIE("Failed to append the image of region #%zu.", i);
+
+        image_deinit(region_image);
+        free(region_image);
+    }
 
     /* Open the output file for writing */
     FILE* output_fp = file_open(args.output_filename, FILE_MODE_WRITE);
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "include/parallel.h"
+
+/*
+ * Arguments for each thread created by 'spawn_jobs'.
+ */
+typedef struct {
+    parallel_func_ptr_t func;
+    void* data;
+    size_t job;
+    size_t start, end;
+} ParallelJob;
+
+/*
+ * Worker thread of the pool, which processes a range of each call to
+ * 'parallel_for'. The workers are never destroyed, so they are reused until
+ * the program exits.
+ */
+typedef struct {
+    pthread_t thread;
+
+    /* Last call to 'parallel_for' seen by the worker */
+    unsigned long generation;
+} ParallelWorker;
+
+/*
+ * Pool of worker threads shared by all the calls to 'parallel_for'. Creating
+ * and joining threads on every call is too slow for callers that process small
+ * amounts of data in each call, such as the streaming functions.
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+
+    /* Signaled when a new call starts, and when all its workers are done */
+    pthread_cond_t start_cond, done_cond;
+
+    ParallelWorker* workers;
+    size_t workers_num;
+
+    /*
+     * Whether a call is using the pool. Calls made at the same time, or from
+     * the jobs of another call, create their own threads instead.
+     */
+    bool busy;
+
+    /* Incremented on each call, so the workers can detect new calls */
+    unsigned long generation;
+
+    /*
+     * Arguments of the current call. The first 'workers_used' workers process
+     * the first ranges, and 'pending' of them haven't finished yet.
+     */
+    parallel_func_ptr_t func;
+    void* data;
+    size_t num_items, jobs;
+    size_t workers_used, pending;
+} ParallelPool;
+
+static ParallelPool g_pool = {
+    .mutex      = PTHREAD_MUTEX_INITIALIZER,
+    .start_cond = PTHREAD_COND_INITIALIZER,
+    .done_cond  = PTHREAD_COND_INITIALIZER,
+};
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Get the start of the range 'job' when splitting 'num_items' items into 'jobs'
+ * ranges. The end of the range is the start of the next one.
+ */
+static inline size_t get_range_start(size_t num_items, size_t jobs, size_t job) {
+    return num_items * job / jobs;
+}
+
+/*
+ * Entry point of each thread created by 'spawn_jobs'.
+ */
+static void* job_entry(void* arg) {
+    const ParallelJob* job = arg;
+    job->func(job->data, job->job, job->start, job->end);
+    return NULL;
+}
+
+/*
+ * Entry point of each worker of the pool. The argument is the index of the
+ * worker, which is also the index of the range it processes.
+ */
+static void* worker_entry(void* arg) {
+    const size_t index = (size_t)(uintptr_t)arg;
+
+    pthread_mutex_lock(&g_pool.mutex);
+    for (;;) {
+        while (g_pool.workers[index].generation == g_pool.generation)
+            pthread_cond_wait(&g_pool.start_cond, &g_pool.mutex);
+        g_pool.workers[index].generation = g_pool.generation;
+
+        if (index >= g_pool.workers_used)
+            continue;
+
+        parallel_func_ptr_t func = g_pool.func;
+        void* data               = g_pool.data;
+        const size_t start =
+          get_range_start(g_pool.num_items, g_pool.jobs, index);
+        const size_t end =
+          get_range_start(g_pool.num_items, g_pool.jobs, index + 1);
+
+        pthread_mutex_unlock(&g_pool.mutex);
+        func(data, index, start, end);
+        pthread_mutex_lock(&g_pool.mutex);
+
+        if (--g_pool.pending == 0)
+            pthread_cond_signal(&g_pool.done_cond);
+    }
+
+    return NULL;
+}
+
+/*
+ * Make sure the pool has at least the specified number of workers, if they
+ * can be created. The mutex of the pool must be locked. Returns the number of
+ * workers in the pool, which might be smaller.
+ */
+static size_t pool_grow(size_t workers_num) {
+    if (workers_num <= g_pool.workers_num)
+        return g_pool.workers_num;
+
+    ParallelWorker* workers =
+      realloc(g_pool.workers, workers_num * sizeof(ParallelWorker));
+    if (workers == NULL)
+        return g_pool.workers_num;
+    g_pool.workers = workers;
+
+    while (g_pool.workers_num < workers_num) {
+        const size_t index = g_pool.workers_num;
+
+        /* The new worker waits for the next call */
+        workers[index].generation = g_pool.generation;
+        if (pthread_create(&workers[index].thread,
+                           NULL,
+                           worker_entry,
+                           (void*)(uintptr_t)index) != 0)
+            break;
+        pthread_detach(workers[index].thread);
+        g_pool.workers_num++;
+    }
+
+    return g_pool.workers_num;
+}
+
+/*
+ * Process each range on a new thread, waiting for all of them to finish. Used
+ * when the pool is busy.
+ */
+static void spawn_jobs(size_t jobs,
+                       size_t num_items,
+                       parallel_func_ptr_t func,
+                       void* data) {
+    ParallelJob* job_args = malloc(jobs * sizeof(ParallelJob));
+    pthread_t* threads    = malloc(jobs * sizeof(pthread_t));
+    bool* created         = calloc(jobs, sizeof(bool));
+    if (job_args == NULL || threads == NULL || created == NULL) {
+        free(job_args);
+        free(threads);
+        free(created);
+        func(data, 0, 0, num_items);
+        return;
+    }
+
+    for (size_t i = 0; i < jobs; i++) {
+        job_args[i].func  = func;
+        job_args[i].data  = data;
+        job_args[i].job   = i;
+        job_args[i].start = get_range_start(num_items, jobs, i);
+        job_args[i].end   = get_range_start(num_items, jobs, i + 1);
+    }
+
+    /* The last range is processed by the calling thread */
+    for (size_t i = 0; i < jobs - 1; i++)
+        created[i] =
+          (pthread_create(&threads[i], NULL, job_entry, &job_args[i]) == 0);
+    job_entry(&job_args[jobs - 1]);
+
+    for (size_t i = 0; i < jobs - 1; i++) {
+        if (created[i])
+            pthread_join(threads[i], NULL);
+        else
+            job_entry(&job_args[i]);
+    }
+
+    free(job_args);
+    free(threads);
+    free(created);
+}
+
+/*----------------------------------------------------------------------------*/
+
+size_t parallel_get_jobs(size_t jobs, size_t num_items) {
+    if (jobs == 0) {
+        const long online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs                   = (online_cpus > 0) ? (size_t)online_cpus : 1;
+    }
+
+    /* There is no point on having jobs without items */
+    if (jobs > num_items)
+        jobs = num_items;
+    if (jobs == 0)
+        jobs = 1;
+
+    return jobs;
+}
+
+void parallel_for(size_t jobs,
+                  size_t num_items,
+                  parallel_func_ptr_t func,
+                  void* data) {
+    jobs = parallel_get_jobs(jobs, num_items);
+    if (jobs <= 1) {
+        func(data, 0, 0, num_items);
+        return;
+    }
+
+    pthread_mutex_lock(&g_pool.mutex);
+    if (g_pool.busy) {
+        pthread_mutex_unlock(&g_pool.mutex);
+        spawn_jobs(jobs, num_items, func, data);
+        return;
+    }
+    g_pool.busy = true;
+
+    /*
+     * The workers process the first ranges, and the calling thread processes
+     * the last one, along with the ones of the workers that couldn't be
+     * created.
+     */
+    size_t workers_used = pool_grow(jobs - 1);
+    if (workers_used > jobs - 1)
+        workers_used = jobs - 1;
+
+    g_pool.func         = func;
+    g_pool.data         = data;
+    g_pool.num_items    = num_items;
+    g_pool.jobs         = jobs;
+    g_pool.workers_used = workers_used;
+    g_pool.pending      = workers_used;
+    g_pool.generation++;
+    pthread_cond_broadcast(&g_pool.start_cond);
+    pthread_mutex_unlock(&g_pool.mutex);
+
+    for (size_t i = workers_used; i < jobs; i++)
+        func(data,
+             i,
+             get_range_start(num_items, jobs, i),
+             get_range_start(num_items, jobs, i + 1));
+
+    pthread_mutex_lock(&g_pool.mutex);
+    while (g_pool.pending > 0)
+        pthread_cond_wait(&g_pool.done_cond, &g_pool.mutex);
+    g_pool.busy = false;
+    pthread_mutex_unlock(&g_pool.mutex);
+}
@@ -0,0 +1,323 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/stream.h"
+#include "include/args.h"
+#include "include/byte_array.h"
+#include "include/image.h"
+#include "include/file.h"
+#include "include/generate.h"
+#include "include/layout.h"
+#include "include/export.h"
+#include "include/util.h"
+
+/*
+ * Calculate the number of layout periods that will be generated from each chunk
+ * of input bytes, when aggregating the specified number of samples into each
+ * pixel. Without a transformation, each period is a row of the image. The
+ * result is never bigger than 'num_periods', the number of periods that contain
+ * the whole input.
+ */
+static size_t get_periods_per_chunk(const Args* args,
+                                    size_t period,
+                                    size_t samples_per_pixel,
+                                    size_t num_periods) {
+    const size_t period_size = period * samples_per_pixel;
+
+    /*
+     * In block-based modes, each chunk must start on a block boundary. The
+     * smallest number of periods whose bytes are a multiple of the block size
+     * is 'block_size / gcd(period_size, block_size)'.
+     */
+    size_t periods_alignment = 1;
+    if (args->mode == ARGS_MODE_ENTROPY)
+        periods_alignment =
+          args->block_size / gcd(period_size, args->block_size);
+
+    /*
+     * When downsampling or transforming, a single period might need more bytes
+     * than the chunk size, so the chunk size is exceeded rather than splitting
+     * periods.
+     */
+    size_t periods = STREAM_CHUNK_SIZE / period_size;
+    if (periods == 0)
+        periods = 1;
+    if (periods % periods_alignment != 0)
+        periods += periods_alignment - periods % periods_alignment;
+
+    /* A single chunk with the whole input doesn't need to be aligned */
+    if (periods > num_periods)
+        periods = num_periods;
+
+    return periods;
+}
+
+/*----------------------------------------------------------------------------*/
+
+bool stream_is_supported(const Args* args, FILE* input_fp) {
+    if (generation_rows_func_from_mode(args->mode) == NULL ||
+        export_rows_func_from_output_format(args->output_format) == NULL ||
+        args->regions_num != 1)
+        return false;
+
+    /*
+     * Leave transformations that can't be applied to the image width to the
+     * regular transformation functions, which will report the error.
+     */
+    size_t period;
+    if (!layout_is_supported(args, args->output_width, &period))
+        return false;
+
+    /*
+     * Leave unusual arguments to the regular generation functions, which will
+     * warn about them or fail accordingly.
+     */
+    switch (args->mode) {
+        case ARGS_MODE_ENTROPY:
+            if (args->block_size <= 1)
+                return false;
+            break;
+        default:
+            if (args->block_size != ARGS_DEFAULT_BLOCK_SIZE)
+                return false;
+            break;
+    }
+
+    /* We need to know the image height before exporting the first row */
+    size_t input_size;
+    if (!file_region_size(input_fp,
+                          args->regions[0].start,
+                          args->regions[0].end,
+                          &input_size) ||
+        input_size == 0)
+        return false;
+
+    /*
+     * A single period is needed in any case, but aligning big periods to the
+     * block size could need much more memory than generating the whole image,
+     * so leave those to the regular generation functions.
+     */
+    const size_t samples_per_pixel =
+      generate_samples_per_pixel(args, input_size);
+    const size_t num_pixels =
+      (input_size + samples_per_pixel - 1) / samples_per_pixel;
+    const size_t num_periods = (num_pixels + period - 1) / period;
+    const size_t periods_per_chunk =
+      get_periods_per_chunk(args, period, samples_per_pixel, num_periods);
+    size_t chunk_size = periods_per_chunk * period * samples_per_pixel;
+    if (chunk_size > input_size)
+        chunk_size = input_size;
+    return periods_per_chunk == 1 || chunk_size <= STREAM_MAX_CHUNK_SIZE;
+}
+
+bool stream_image(const Args* args, FILE* input_fp, FILE* output_fp) {
+    generation_image_init_func_ptr_t generation_image_init_func =
+      generation_image_init_func_from_mode(args->mode);
+    generation_rows_func_ptr_t generation_rows_func =
+      generation_rows_func_from_mode(args->mode);
+    export_rows_func_ptr_t export_rows_func =
+      export_rows_func_from_output_format(args->output_format);
+    assert(generation_image_init_func != NULL &&
+           generation_rows_func != NULL && export_rows_func != NULL);
+
+    size_t input_size;
+    if (!file_region_size(input_fp,
+                          args->regions[0].start,
+                          args->regions[0].end,
+                          &input_size))
+        return false;
+
+    /*
+     * Dimensions of the whole linear image, which will never be in memory. Each
+     * pixel might aggregate multiple samples if the image would be too big.
+     */
+    const size_t samples_per_pixel =
+      generate_samples_per_pixel(args, input_size);
+    const size_t num_pixels =
+      (input_size + samples_per_pixel - 1) / samples_per_pixel;
+    const size_t width = args->output_width;
+    size_t height      = num_pixels / width;
+    if (num_pixels % width != 0)
+        height++;
+
+    /*
+     * The pixels of each period of the layout are moved inside that period, so
+     * they can be transformed as soon as they are generated.
+     */
+    Layout layout;
+    if (!layout_init(&layout, args, width, height)) {
+        ERR("Failed to initialize the image layout.");
+        return false;
+    }
+
+    /*
+     * Buffers for a single chunk, reused for the whole input. The last periods
+     * might need more bytes than the input has.
+     */
+    const size_t num_periods = (num_pixels + layout.period - 1) / layout.period;
+    const size_t periods_per_chunk = get_periods_per_chunk(args,
+                                                           layout.period,
+                                                           samples_per_pixel,
+                                                           num_periods);
+    size_t chunk_size = periods_per_chunk * layout.period * samples_per_pixel;
+    if (chunk_size > input_size)
+        chunk_size = input_size;
+
+    uint8_t* chunk_data = malloc(chunk_size);
+    if (chunk_data == NULL) {
+        ERR("Failed to allocate input chunk.");
+        layout_deinit(&layout);
+        return false;
+    }
+
+    /*
+     * The generated chunk contains a period in each row. Unless the layout
+     * doesn't move any pixel, the transformed rows are stored separately.
+     */
+    Image chunk_image, layout_image;
+    const bool use_layout_image = !layout_is_identity(&layout);
+    const size_t layout_rows_per_chunk =
+      periods_per_chunk * layout.period / layout.width;
+    if (!generation_image_init_func(&chunk_image,
+                                    layout.period,
+                                    periods_per_chunk)) {
+        ERR("Failed to allocate image chunk.");
+        free(chunk_data);
+        layout_deinit(&layout);
+        return false;
+    }
+    if (use_layout_image &&
+        !generation_image_init_func(&layout_image,
+                                    layout.width,
+                                    layout_rows_per_chunk)) {
+        ERR("Failed to allocate image chunk.");
+        image_deinit(&chunk_image);
+        free(chunk_data);
+        layout_deinit(&layout);
+        return false;
+    }
+    Image* exported_image = use_layout_image ? &layout_image : &chunk_image;
+
+    if (!file_skip(input_fp, args->regions[0].start)) {
+        if (use_layout_image)
+            image_deinit(&layout_image);
+        image_deinit(&chunk_image);
+        free(chunk_data);
+        layout_deinit(&layout);
+        return false;
+    }
+
+    ExportStream stream = {
+        .args         = args,
+        .output_fp    = output_fp,
+        .width        = layout.width,
+        .height       = layout.height,
+        .rows_written = 0,
+        .format       = chunk_image.format,
+        .palette      = (chunk_image.format == IMAGE_FORMAT_INDEXED8)
+                          ? &chunk_image.palette
+                          : NULL,
+        .data         = NULL,
+    };
+
+    bool result             = true;
+    size_t remaining_bytes  = input_size;
+    size_t remaining_pixels = width * height;
+    while (stream.rows_written < layout.height) {
+        const size_t bytes_to_read =
+          (remaining_bytes < chunk_size) ? remaining_bytes : chunk_size;
+        const size_t bytes_read =
+          fread(chunk_data, 1, bytes_to_read, input_fp);
+        remaining_bytes -= bytes_read;
+
+        /* Number of periods that contain the remaining rows of the layout */
+        const size_t remaining_rows = layout.height - stream.rows_written;
+        chunk_image.height =
+          (remaining_rows * layout.width + layout.period - 1) / layout.period;
+        if (chunk_image.height > periods_per_chunk)
+            chunk_image.height = periods_per_chunk;
+
+        /*
+         * If the file was truncated while we were reading it, we still need to
+         * export the rows we promised, so fill them with black.
+         */
+        if (bytes_read <
+            chunk_image.width * chunk_image.height * samples_per_pixel)
+            memset(chunk_image.data,
+                   0,
+                   chunk_image.width * chunk_image.height *
+                     image_pixel_size(chunk_image.format));
+
+        const ByteArray chunk_bytes = {
+            .data         = chunk_data,
+            .size         = bytes_read,
+            .mapping      = NULL,
+            .mapping_size = 0,
+        };
+        if (!generation_rows_func(args,
+                                  &chunk_bytes,
+                                  samples_per_pixel,
+                                  &chunk_image)) {
+            ERR("Failed to generate image rows.");
+            export_rows_func(&stream, NULL);
+            result = false;
+            break;
+        }
+
+        /*
+         * Move the pixels of the generated periods to their rows. The pixels
+         * after the end of the linear image are not moved, so they stay black.
+         */
+        const size_t chunk_pixels = chunk_image.width * chunk_image.height;
+        const size_t used_pixels  = (remaining_pixels < chunk_pixels)
+                                      ? remaining_pixels
+                                      : chunk_pixels;
+        remaining_pixels -= used_pixels;
+        if (use_layout_image) {
+            layout_image.height = (remaining_rows < layout_rows_per_chunk)
+                                    ? remaining_rows
+                                    : layout_rows_per_chunk;
+            layout_apply(args,
+                         &layout,
+                         &chunk_image,
+                         used_pixels,
+                         &layout_image);
+        }
+
+        if (!export_rows_func(&stream, exported_image)) {
+            result = false;
+            break;
+        }
+    }
+
+    if (result)
+        result = export_rows_func(&stream, NULL);
+
+    if (use_layout_image)
+        image_deinit(&layout_image);
+    image_deinit(&chunk_image);
+    free(chunk_data);
+    layout_deinit(&layout);
+    return result;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+
+#include "include/transform.h"
+#include "include/args.h"
+#include "include/image.h"
+#include "include/layout.h"
+#include "include/util.h"
+
+static bool validate_args(const Args* args) {
+    switch (args->mode) {
+        case ARGS_MODE_HISTOGRAM:
+        case ARGS_MODE_ENTROPY_HISTOGRAM:
+        case ARGS_MODE_BIGRAMS:
+        case ARGS_MODE_DOTPLOT:
+        case ARGS_MODE_DOTPLOT_DENSITY:
+        case ARGS_MODE_DOTPLOT_KGRAM:
+            for (size_t i = 0; i < args->transforms_num; i++)
+                WRN("The \"%s\" transformation is not recommended for the "
+                    "current mode (%s).",
+                    args_get_transform_name(args->transforms[i].type),
+                    args_get_mode_name(args->mode));
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+bool transform_image(const Args* args, Image* image) {
+    if (!validate_args(args))
+        return false;
+
+    /*
+     * The layout combines all the transformations, increasing the width and
+     * height of the image if needed.
+     */
+    Layout layout;
+    if (!layout_init(&layout, args, image->width, image->height)) {
+        ERR("Failed to initialize the transformation layout.");
+        return false;
+    }
+
+    const bool result = layout_apply_to_image(args, &layout, image);
+    if (!result)
+        ERR("Failed to allocate new pixels array.");
+
+    layout_deinit(&layout);
+    return result;
+}
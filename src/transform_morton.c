@@ -0,0 +1,123 @@
+/*
+ * Copyright 2025 8dcc
+ *
+ * This file is part of bin-graph.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "include/transform.h"
+#include "include/args.h"
+#include "include/layout.h"
+#include "include/parallel.h"
+#include "include/util.h"
+
+/*
+ * Context shared by all the threads that fill the offsets of a Morton curve
+ * layout.
+ */
+typedef struct {
+    Layout* layout;
+
+#if !defined(__BMI2__)
+    /*
+     * Part of the offset of a point that depends on each byte of its position
+     * in the curve. The offset is linear on the coordinates, and each bit of
+     * the position belongs to a single coordinate, so the offset is the sum of
+     * the parts of each byte.
+     */
+    uint32_t byte_offsets[sizeof(uint32_t)][UCHAR_MAX + 1];
+#endif
+} MortonCtx;
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * Get the offset of the specified point of a Morton curve, whose coordinates
+ * are the even (X) and odd (Y) bits of its position.
+ */
+static inline uint32_t morton_offset(const MortonCtx* ctx, uint32_t point) {
+#if defined(__BMI2__)
+    const uint32_t x = _pext_u32(point, 0x55555555);
+    const uint32_t y = _pext_u32(point, 0xAAAAAAAA);
+    return (ctx->layout->width * y + x) * ctx->layout->run;
+#else
+    return ctx->byte_offsets[0][point & 0xFF] +
+           ctx->byte_offsets[1][(point >> 8) & 0xFF] +
+           ctx->byte_offsets[2][(point >> 16) & 0xFF] +
+           ctx->byte_offsets[3][point >> 24];
+#endif
+}
+
+/*
+ * Fill the offsets of the Morton curve points in the [start..end) range.
+ */
+static void morton_job(void* data, size_t job, size_t start, size_t end) {
+    UNUSED(job);
+
+    const MortonCtx* ctx    = data;
+    const size_t width      = ctx->layout->width;
+    const size_t block_side = ctx->layout->run;
+
+    uint32_t* offsets = &ctx->layout->offsets[start * block_side];
+    for (size_t point = start; point < end; point++) {
+        const uint32_t base = morton_offset(ctx, point);
+
+        /* Each row of the block is a run, like in the Hilbert curves */
+        for (size_t row = 0; row < block_side; row++)
+            *offsets++ = base + width * row;
+    }
+}
+
+void transform_morton_offsets(const Args* args,
+                              Layout* layout,
+                              size_t level) {
+    /*
+     * The curves have the same geometry as the Hilbert curves, but the
+     * coordinates of each point only depend on its position in the curve, so
+     * the points are filled in parallel.
+     */
+    const size_t points_num = (size_t)1 << (2 * level);
+    assert(points_num - 1 <= UINT32_MAX);
+
+    MortonCtx ctx;
+    ctx.layout = layout;
+
+#if !defined(__BMI2__)
+    for (size_t i = 0; i < sizeof(uint32_t); i++) {
+        for (uint32_t byte = 0; byte <= UCHAR_MAX; byte++) {
+            uint32_t x = 0, y = 0;
+            for (int bit = 0; bit < 4; bit++) {
+                x |= ((byte >> (2 * bit)) & 1) << bit;
+                y |= ((byte >> (2 * bit + 1)) & 1) << bit;
+            }
+
+            /* Each byte contains 4 bits of each coordinate */
+            x <<= 4 * i;
+            y <<= 4 * i;
+            ctx.byte_offsets[i][byte] = (layout->width * y + x) * layout->run;
+        }
+    }
+#endif
+
+    parallel_for(args->jobs, points_num, morton_job, &ctx);
+}
@@ -20,23 +20,25 @@
 
 #include "include/transform.h"
 #include "include/args.h"
-#include "include/image.h"
+#include "include/layout.h"
 #include "include/util.h"
 
-bool transform_zigzag(const Args* args, Image* image) {
-    UNUSED(args);
+bool transform_zigzag_geometry(Layout* layout, size_t param) {
+    UNUSED(param);
 
-    for (size_t y = 0; y < image->height; y++) {
-        /* Don't reverse even rows */
-        if (y % 2 == 0)
-            continue;
+    /* Each period is a pair of rows, and the pixels are moved one by one */
+    layout->period = 2 * layout->width;
+    layout->run    = 1;
+    return true;
+}
 
-        /* Reverse odd rows, swapping bytes from the start and the end */
-        if (reverse_buffer(&image->pixels[image->width * y],
-                           image->width,
-                           sizeof(Color)) == NULL)
-            break;
-    }
+void transform_zigzag_offsets(const Args* args, Layout* layout, size_t param) {
+    UNUSED(args);
+    UNUSED(param);
 
-    return true;
+    const size_t width = layout->width;
+    for (size_t x = 0; x < width; x++) {
+        layout->offsets[x]         = x;
+        layout->offsets[width + x] = 2 * width - 1 - x;
+    }
 }